@@ -0,0 +1,1234 @@
+// NightlyHeap.h - implements a generational garbage-collected heap for runtime evaluation,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// `nbe_engine` allocates its thunks, environments and values in a bump arena that is only
+// rewound between terms, so one long normalization holds on to every value it ever created.
+// At compile time a type that is no longer named costs nothing; `term_heap` gives the runtime
+// the same property. It holds fixed-size cells addressed by 32-bit `heap_ref`s:
+//
+//   - new cells go to a nursery that is collected by Cheney copying once it fills up, so the
+//     cost of a minor collection is the number of survivors, not the garbage,
+//   - a cell that survives `promotion_age` collections is promoted to the tenured space, where
+//     it never moves again; a major collection marks the tenured space from a snapshot of the
+//     roots and sweeps its dead cells into a free list, in steps of `major_step_cells` taken
+//     halfway between two minor collections, so that neither pause grows with the live set,
+//   - the tenured space is allocated in blocks, and a block the sweep finds no live cell in is
+//     freed; it is never compacted, so a block keeping one live cell keeps all of its memory,
+//   - it starts when the tenured space outgrows its limit; while the tenured space is small, a
+//     whole one runs before every minor collection instead, so that dead tenured thunks let go
+//     of the young values they were updated with before the nursery is copied,
+//   - `store_first` and `store_second` remember tenured cells that come to point into the
+//     nursery, the only way such pointers can arise, and minor collections trace from them;
+//     while marking, they also mark the reference they overwrite.
+//
+// Young cells move, so the mutator must register every `heap_ref` it keeps with `add_root` or
+// `add_roots` and collect only at points where nothing else is held: allocation never
+// collects, `collect_if_needed` does. A deep stack of references belongs in a
+// `heap_root_stack`, of which a minor collection only looks at what changed since the last.
+// `heap_engine` normalizes like `nbe_engine`, but as a machine whose whole stack and
+// environment live in registered roots, so that it reaches such a point after every step and
+// its memory stays flat however long the normalization runs.
+
+#pragma once
+#ifndef YUAN_NIGHTLY_HEAP
+#define YUAN_NIGHTLY_HEAP
+
+#include "NightlyNbe.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace nightly_lambda {
+namespace runtime {
+
+using heap_ref = std::uint32_t;
+
+inline constexpr heap_ref null_heap_ref = std::numeric_limits<heap_ref>::max();
+
+// STRUCT heap_cell
+struct heap_cell {
+    unsigned char tag;        // chosen by the mutator, except the reserved `term_heap` tags
+    unsigned char age;        // collections survived while young
+    unsigned char remembered; // tenured and listed in the remembered set
+    unsigned char marked;     // found alive by the current major collection
+    std::uint32_t data;       // not traced
+    heap_ref first;           // traced unless null_heap_ref
+    heap_ref second;          // traced unless null_heap_ref
+};
+
+// STRUCT heap_options
+struct heap_options {
+    size_t nursery_cells = size_t{1} << 13;    // a minor collection when the nursery holds this many
+    unsigned promotion_age = 2;                // collections survived before promotion
+    size_t tenured_cells = size_t{1} << 18;    // a major collection when the tenured space holds this many
+    unsigned tenured_growth = 2;               // after a major collection, the limit is at least
+                                               // this multiple of the survivors
+    unsigned whole_percent = 25;               // a whole major collection before every minor one
+                                               // while the tenured space is at most this
+                                               // percentage of the nursery
+    size_t major_step_cells = size_t{1} << 13; // cells marked or swept, or roots scanned, by one
+                                               // step of a major collection, plus twice the
+                                               // cells promoted since the last step
+};
+
+// STRUCT heap_stats
+struct heap_stats {
+    std::uint64_t allocated = 0;          // cells
+    std::uint64_t copied = 0;             // cells moved by minor collections
+    std::uint64_t promoted = 0;           // cells moved from the nursery into the tenured space
+    std::uint64_t freed = 0;              // tenured cells swept by major collections
+    std::uint64_t minor_collections = 0;
+    std::uint64_t major_collections = 0;  // completed
+    std::uint64_t major_steps = 0;        // bounded pieces of work, the snapshots included
+    std::uint64_t pause_ns = 0;           // all collections together
+    std::uint64_t max_minor_pause_ns = 0;
+    std::uint64_t max_major_pause_ns = 0; // the longest step
+    std::uint64_t slow_pauses = 0;        // longer than a millisecond
+    size_t peak_reserved_bytes = 0;
+};
+
+class term_heap;
+
+// CLASS heap_root_stack
+class heap_root_stack { // roots that change only at the end, so that a collection looks at what
+                        // changed since the last one rather than at every element
+public:
+    heap_root_stack() = default;
+    heap_root_stack(const heap_root_stack&) = delete;
+    heap_root_stack& operator=(const heap_root_stack&) = delete;
+    ~heap_root_stack();
+
+    void push_back(heap_ref _Ref)
+    {
+        _Refs.push_back(_Ref);
+    }
+
+    void pop_back();
+
+    void clear()
+    {
+        while (!_Refs.empty()) {
+            pop_back();
+        }
+    }
+
+    heap_ref back() const noexcept
+    {
+        return _Refs.back();
+    }
+
+    heap_ref operator[](size_t _Idx) const noexcept
+    {
+        return _Refs[_Idx];
+    }
+
+    size_t size() const noexcept
+    {
+        return _Refs.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return _Refs.empty();
+    }
+
+private:
+    friend term_heap;
+
+    std::vector<heap_ref> _Refs;
+    term_heap* _Heap = nullptr;
+    size_t _Low = 0;       // the fewest elements since the last minor collection
+    size_t _Old_below = 0; // no element below refers to the nursery, as of the last one
+    size_t _Mark_pos = 0;  // the elements in [_Mark_pos, _Mark_end) are still to be marked
+    size_t _Mark_end = 0;
+};
+
+// CLASS term_heap
+class term_heap {
+public:
+    static constexpr unsigned char forwarded_tag = 0xff;
+    static constexpr unsigned char free_tag = 0xfe;
+
+    explicit term_heap(const heap_options& _Options_ = heap_options{}) : _Options(_Options_)
+    {
+        if (_Options.nursery_cells == 0 || _Options.nursery_cells > _Max_cells
+            || _Options.promotion_age == 0 || _Options.promotion_age > 254
+            || _Options.tenured_growth == 0 || _Options.whole_percent > 100
+            || _Options.major_step_cells == 0) {
+            throw std::invalid_argument("invalid heap_options");
+        }
+
+        _Nursery.reserve(_Options.nursery_cells + _Safe_point_slack);
+        _Survivors.reserve(_Options.nursery_cells + _Safe_point_slack);
+        _Major_limit = _Options.tenured_cells;
+    }
+
+    term_heap(const term_heap&) = delete;
+    term_heap& operator=(const term_heap&) = delete;
+
+    ~term_heap()
+    {
+        for (heap_root_stack* const _Stack : _Root_stacks) {
+            _Stack->_Heap = nullptr;
+        }
+    }
+
+    heap_ref allocate(unsigned char _Tag, std::uint32_t _Data, heap_ref _First, heap_ref _Second)
+    { // never collects; the nursery may run past its size until the next `collect_if_needed`
+        if (_Nursery.size() >= _Max_cells) {
+            throw std::length_error("term_heap nursery exhausted");
+        }
+
+        ++_Stats.allocated;
+        _Nursery.push_back({_Tag, 0, 0, 0, _Data, _First, _Second});
+        return static_cast<heap_ref>(_Nursery.size() - 1);
+    }
+
+    const heap_cell& operator[](heap_ref _Ref) const noexcept
+    {
+        return (_Ref & _Tenured_bit) != 0 ? _Tenured_at(_Ref & ~_Tenured_bit) : _Nursery[_Ref];
+    }
+
+    void store_first(heap_ref _Ref, heap_ref _Value)
+    {
+        heap_cell& _Target = _Cell(_Ref);
+        _Deleted(_Target.first);
+        _Target.first = _Value;
+        _Remember(_Ref, _Value);
+    }
+
+    void store_second(heap_ref _Ref, heap_ref _Value)
+    {
+        heap_cell& _Target = _Cell(_Ref);
+        _Deleted(_Target.second);
+        _Target.second = _Value;
+        _Remember(_Ref, _Value);
+    }
+
+    void add_root(heap_ref* _Slot)
+    {
+        _Root_slots.push_back(_Slot);
+    }
+
+    void remove_root(heap_ref* _Slot) noexcept
+    {
+        const auto _Found = std::find(_Root_slots.rbegin(), _Root_slots.rend(), _Slot);
+        if (_Found != _Root_slots.rend()) {
+            _Root_slots.erase(std::next(_Found).base());
+        }
+    }
+
+    void add_roots(std::vector<heap_ref>* _Slots)
+    { // every element is a root, however the vector grows and shrinks; every collection looks
+      // at all of them, so keep deep stacks in a `heap_root_stack` instead
+        _Root_vectors.push_back(_Slots);
+    }
+
+    void remove_roots(std::vector<heap_ref>* _Slots) noexcept
+    {
+        const auto _Found = std::find(_Root_vectors.rbegin(), _Root_vectors.rend(), _Slots);
+        if (_Found != _Root_vectors.rend()) {
+            _Root_vectors.erase(std::next(_Found).base());
+        }
+    }
+
+    void add_roots(heap_root_stack* _Stack)
+    {
+        _Root_stacks.push_back(_Stack);
+        _Stack->_Heap = this;
+        _Stack->_Low = 0;
+        _Stack->_Old_below = 0;
+        _Stack->_Mark_pos = 0;
+        _Stack->_Mark_end = _Phase == _Major_phase::_Marking ? _Stack->size() : 0;
+    }
+
+    void remove_roots(heap_root_stack* _Stack)
+    {
+        const auto _Found = std::find(_Root_stacks.rbegin(), _Root_stacks.rend(), _Stack);
+        if (_Found != _Root_stacks.rend()) {
+            _Root_stacks.erase(std::next(_Found).base());
+            for (size_t _Idx = _Stack->_Mark_pos; _Idx < _Stack->_Mark_end; ++_Idx) {
+                _Shade(_Stack->_Refs[_Idx]); // its elements were alive when marking began
+            }
+
+            _Stack->_Heap = nullptr;
+            _Stack->_Mark_end = 0;
+        }
+    }
+
+    bool collect_if_needed()
+    { // the safe point: only registered roots keep cells alive
+        if (_Nursery.size() < _Options.nursery_cells) {
+            if (_Step_due && _Nursery.size() >= _Options.nursery_cells / 2) { // halfway to the next
+                _Step_due = false;                                             // minor collection
+                _Major_step(_Options.major_step_cells + 2 * _Unpaced); // outpaces the promotions
+                _Unpaced = 0;
+                return true;
+            }
+
+            return false;
+        }
+
+        if (_Phase == _Major_phase::_Idle && _Tenured_size * 100 <= _Options.nursery_cells * _Options.whole_percent
+            && _Stacked() <= _Options.major_step_cells) {
+            // no dearer than the minor collection, and dead tenured thunks updated with young
+            // values let go of them before it, instead of keeping whole chains of garbage alive
+            collect_major();
+        }
+
+        collect_minor();
+        if (_Phase == _Major_phase::_Idle && _Tenured_used >= _Major_limit) {
+            _Start_major();
+        }
+
+        _Step_due = _Phase != _Major_phase::_Idle;
+        return true;
+    }
+
+    void collect_minor()
+    { // copies what the roots and the remembered set reach in the nursery
+        const auto _Start = std::chrono::steady_clock::now();
+        _Collect();
+        ++_Stats.minor_collections;
+        _Finish(_Start, _Stats.max_minor_pause_ns);
+    }
+
+    void collect_major()
+    { // finishes the major collection under way, or runs a whole one, in a single pause
+        if (_Phase == _Major_phase::_Idle) {
+            _Start_major();
+        }
+
+        while (_Phase != _Major_phase::_Idle) {
+            _Major_step(std::numeric_limits<size_t>::max());
+        }
+
+        _Step_due = false;
+    }
+
+    void clear() noexcept
+    { // drops every cell but keeps the memory, the roots and the statistics
+        _Nursery.clear();
+        _Tenured_size = 0;
+        _Remembered.clear();
+        _Mark_stack.clear();
+        _Young_stack.clear();
+        _Free = null_heap_ref;
+        _Empty_blocks.clear();
+        _Tenured_used = 0;
+        _Major_limit = _Options.tenured_cells;
+        _Step_due = false;
+        _Young_marked = false;
+        _Unpaced = 0;
+        _Phase = _Major_phase::_Idle;
+        for (heap_root_stack* const _Stack : _Root_stacks) {
+            _Stack->_Low = 0;
+            _Stack->_Old_below = 0;
+            _Stack->_Mark_pos = 0;
+            _Stack->_Mark_end = 0;
+        }
+    }
+
+    size_t cell_count() const noexcept
+    { // the tenured cells not yet found dead included
+        return _Nursery.size() + _Tenured_used;
+    }
+
+    size_t reserved_bytes() const noexcept
+    {
+        return (_Nursery.capacity() + _Survivors.capacity() + (_Block_count << _Block_bits))
+                * sizeof(heap_cell)
+            + (_Remembered.capacity() + _Old_remembered.capacity() + _Promoted.capacity()
+                + _Mark_stack.capacity()) * sizeof(heap_ref);
+    }
+
+    const heap_options& options() const noexcept
+    {
+        return _Options;
+    }
+
+    const heap_stats& stats() const noexcept
+    {
+        return _Stats;
+    }
+
+private:
+    friend heap_root_stack;
+
+    // A major collection marks the tenured cells alive when it began, in steps, and then sweeps
+    // the dead ones into a free list, also in steps; tenured cells never move. Everything that
+    // was reachable when marking began stays marked because the mutator shades every reference
+    // it removes from the heap or from a root stack before it is marked, the young cells of that
+    // moment are scanned at once, and cells promoted while marking are marked already.
+
+    enum class _Major_phase : unsigned char { _Idle, _Marking, _Sweeping };
+
+    static constexpr heap_ref _Tenured_bit = heap_ref{1} << 31;
+    static constexpr size_t _Max_cells = _Tenured_bit - 1; // null_heap_ref stays free
+    static constexpr size_t _Safe_point_slack = 64;         // allocations between two safe points
+    static constexpr unsigned _Block_bits = 14;             // tenured cells by block
+    static constexpr size_t _Block_cells = size_t{1} << _Block_bits;
+
+    static bool _Is_young(heap_ref _Ref) noexcept
+    {
+        return _Ref != null_heap_ref && (_Ref & _Tenured_bit) == 0;
+    }
+
+    static bool _Is_tenured(heap_ref _Ref) noexcept
+    {
+        return _Ref != null_heap_ref && (_Ref & _Tenured_bit) != 0;
+    }
+
+    heap_cell& _Tenured_at(heap_ref _Idx) const noexcept
+    {
+        return _Tenured_blocks[_Idx >> _Block_bits][_Idx & ((heap_ref{1} << _Block_bits) - 1)];
+    }
+
+    heap_cell& _Cell(heap_ref _Ref) noexcept
+    {
+        return (_Ref & _Tenured_bit) != 0 ? _Tenured_at(_Ref & ~_Tenured_bit) : _Nursery[_Ref];
+    }
+
+    void _Remember(heap_ref _Ref, heap_ref _Value)
+    {
+        if ((_Ref & _Tenured_bit) != 0 && _Is_young(_Value)) {
+            heap_cell& _Target = _Tenured_at(_Ref & ~_Tenured_bit);
+            if (_Target.remembered == 0) {
+                _Target.remembered = 1;
+                _Remembered.push_back(_Ref & ~_Tenured_bit);
+            }
+        }
+    }
+
+    void _Deleted(heap_ref _Old)
+    {
+        if (_Phase == _Major_phase::_Marking) {
+            _Shade(_Old);
+        }
+    }
+
+    void _Shade(heap_ref _Ref)
+    { // a cell found alive: a tenured one has its children marked from `_Mark_stack`, a young
+      // one may move before then and is traced at once, as far as the tenured cells it reaches
+        if (_Is_tenured(_Ref)) {
+            heap_cell& _Target = _Tenured_at(_Ref & ~_Tenured_bit);
+            if (_Target.marked == 0) {
+                _Target.marked = 1;
+                _Mark_stack.push_back(_Ref & ~_Tenured_bit);
+            }
+
+            return;
+        }
+
+        if (_Ref == null_heap_ref || _Nursery[_Ref].marked != 0) {
+            return;
+        }
+
+        _Nursery[_Ref].marked = 1;
+        _Young_marked = true;
+        _Young_stack.push_back(_Ref);
+        while (!_Young_stack.empty()) { // at most the nursery between two minor collections
+            const heap_cell _Young = _Nursery[_Young_stack.back()];
+            _Young_stack.pop_back();
+            for (const heap_ref _Child : {_Young.first, _Young.second}) {
+                if (_Is_young(_Child)) {
+                    if (_Nursery[_Child].marked == 0) {
+                        _Nursery[_Child].marked = 1;
+                        _Young_stack.push_back(_Child);
+                    }
+                } else {
+                    _Shade(_Child);
+                }
+            }
+        }
+    }
+
+    size_t _Stacked() const noexcept
+    {
+        size_t _Count = 0;
+        for (const heap_root_stack* const _Stack : _Root_stacks) {
+            _Count += _Stack->size();
+        }
+
+        return _Count;
+    }
+
+    template <class _Fn>
+    void _Visit_roots(_Fn&& _Visit)
+    {
+        for (heap_ref* const _Slot : _Root_slots) {
+            _Visit(*_Slot);
+        }
+
+        for (std::vector<heap_ref>* const _Slots : _Root_vectors) {
+            for (heap_ref& _Ref : *_Slots) {
+                _Visit(_Ref);
+            }
+        }
+    }
+
+    heap_ref _Promote(const heap_cell& _Copy)
+    { // into a free tenured cell, kept by the major collection under way
+        if (_Free == null_heap_ref) {
+            _Reuse_block();
+        }
+
+        heap_ref _Idx;
+        if (_Free != null_heap_ref) {
+            _Idx = _Free;
+            _Unlink(_Idx);
+        } else {
+            if (_Tenured_size >= _Max_cells) {
+                throw std::length_error("term_heap tenured space exhausted");
+            }
+
+            const size_t _Block = _Tenured_size >> _Block_bits;
+            if (_Block == _Tenured_blocks.size()) { // grows without copying
+                _Tenured_blocks.emplace_back();
+            }
+
+            if (!_Tenured_blocks[_Block]) {
+                _Tenured_blocks[_Block] = std::make_unique<heap_cell[]>(_Block_cells);
+                ++_Block_count;
+            }
+
+            _Idx = static_cast<heap_ref>(_Tenured_size++);
+        }
+
+        heap_cell& _Target = _Tenured_at(_Idx);
+        _Target = _Copy;
+        _Target.marked = _Phase == _Major_phase::_Sweeping && _Idx >= _Sweep_pos && _Idx < _Sweep_end;
+        ++_Tenured_used;
+        ++_Unpaced;
+        _Promoted.push_back(_Idx);
+        if (_Phase == _Major_phase::_Marking) { // it may not have been traced as a young cell
+            _Shade(_Idx | _Tenured_bit);
+        }
+
+        return _Idx | _Tenured_bit;
+    }
+
+    void _Link(heap_ref _Idx) noexcept
+    { // onto the free list, doubly linked through `first` and `second` so that a block can leave it
+        heap_cell& _Target = _Tenured_at(_Idx);
+        _Target.tag = free_tag;
+        _Target.marked = 0;
+        _Target.remembered = 0;
+        _Target.first = _Free;
+        _Target.second = null_heap_ref;
+        if (_Free != null_heap_ref) {
+            _Tenured_at(_Free).second = _Idx;
+        }
+
+        _Free = _Idx;
+    }
+
+    void _Unlink(heap_ref _Idx) noexcept
+    {
+        const heap_cell& _Target = _Tenured_at(_Idx);
+        if (_Target.second != null_heap_ref) {
+            _Tenured_at(_Target.second).first = _Target.first;
+        } else {
+            _Free = _Target.first;
+        }
+
+        if (_Target.first != null_heap_ref) {
+            _Tenured_at(_Target.first).second = _Target.second;
+        }
+    }
+
+    bool _Is_free(heap_ref _Idx) const noexcept
+    { // including the cells of released blocks
+        const size_t _Block = _Idx >> _Block_bits;
+        return _Block >= _Tenured_blocks.size() || !_Tenured_blocks[_Block] || _Tenured_at(_Idx).tag == free_tag;
+    }
+
+    void _Reuse_block()
+    { // allocates a block released below the top again, its cells all free
+        while (!_Empty_blocks.empty()) {
+            const size_t _Block = _Empty_blocks.back();
+            _Empty_blocks.pop_back();
+            if (((_Block + 1) << _Block_bits) <= _Tenured_size && !_Tenured_blocks[_Block]) {
+                _Tenured_blocks[_Block] = std::make_unique<heap_cell[]>(_Block_cells);
+                ++_Block_count;
+                for (size_t _Idx = _Block_cells; _Idx-- != 0;) {
+                    _Link(static_cast<heap_ref>((_Block << _Block_bits) + _Idx));
+                }
+
+                return;
+            }
+        }
+    }
+
+    void _Release_block(size_t _Block) noexcept
+    { // whose cells are all free, the blocks at the top shrink the tenured space
+        const size_t _First = _Block << _Block_bits;
+        const size_t _Last = std::min(_First + _Block_cells, _Tenured_size);
+        for (size_t _Idx = _First; _Idx < _Last; ++_Idx) {
+            _Unlink(static_cast<heap_ref>(_Idx));
+        }
+
+        _Tenured_blocks[_Block].reset();
+        --_Block_count;
+        _Empty_blocks.push_back(_Block);
+        while (_Tenured_size != 0 && !_Tenured_blocks[(_Tenured_size - 1) >> _Block_bits]) {
+            _Tenured_size = ((_Tenured_size - 1) >> _Block_bits) << _Block_bits;
+        }
+
+        while (!_Tenured_blocks.empty() && !_Tenured_blocks.back()) {
+            _Tenured_blocks.pop_back();
+        }
+
+        _Sweep_end = std::min(_Sweep_end, _Tenured_size);
+    }
+
+    heap_ref _Evacuate(heap_ref _Ref)
+    { // moves a nursery cell into the survivors or, old enough, into the tenured space
+        if (!_Is_young(_Ref)) {
+            return _Ref;
+        }
+
+        heap_cell& _Old = _Nursery[_Ref];
+        if (_Old.tag == forwarded_tag) {
+            return _Old.data;
+        }
+
+        heap_cell _Copy = _Old;
+        _Copy.age = static_cast<unsigned char>(_Copy.age + 1);
+        _Copy.marked = 0;
+        heap_ref _New;
+        if (_Copy.age >= _Options.promotion_age) {
+            _New = _Promote(_Copy);
+            ++_Stats.promoted;
+        } else {
+            _New = static_cast<heap_ref>(_Survivors.size());
+            _Survivors.push_back(_Copy);
+        }
+
+        ++_Stats.copied;
+        _Old.tag = forwarded_tag;
+        _Old.data = _New;
+        return _New;
+    }
+
+    void _Scan_tenured(heap_ref _Idx)
+    { // moves the children of a tenured cell and remembers it if any stays young
+        const heap_ref _First = _Evacuate(_Tenured_at(_Idx).first);
+        const heap_ref _Second = _Evacuate(_Tenured_at(_Idx).second);
+        heap_cell& _Target = _Tenured_at(_Idx);
+        _Target.first = _First;
+        _Target.second = _Second;
+        if ((_Is_young(_First) || _Is_young(_Second)) && _Target.remembered == 0) {
+            _Target.remembered = 1;
+            _Remembered.push_back(_Idx);
+        }
+    }
+
+    void _Scan_stack(heap_root_stack& _Stack)
+    { // what was popped and pushed since the last minor collection, and what was young then
+        const size_t _Size = _Stack.size();
+        size_t _Idx = std::min(_Stack._Low, _Stack._Old_below);
+        _Stack._Old_below = _Size;
+        for (; _Idx < _Size; ++_Idx) {
+            heap_ref& _Ref = _Stack._Refs[_Idx];
+            _Ref = _Evacuate(_Ref);
+            if (_Is_young(_Ref) && _Stack._Old_below == _Size) {
+                _Stack._Old_below = _Idx;
+            }
+        }
+
+        _Stack._Low = _Size;
+    }
+
+    void _Collect()
+    { // Cheney: the copies are the queue, scanned until neither space grows
+        _Survivors.clear();
+        _Promoted.clear();
+        _Visit_roots([this](heap_ref& _Ref) { _Ref = _Evacuate(_Ref); });
+        for (heap_root_stack* const _Stack : _Root_stacks) {
+            _Scan_stack(*_Stack);
+        }
+
+        _Old_remembered.swap(_Remembered);
+        _Remembered.clear();
+        for (const heap_ref _Idx : _Old_remembered) {
+            if (!_Is_free(_Idx)) { // not swept since it was remembered
+                _Tenured_at(_Idx).remembered = 0;
+                _Scan_tenured(_Idx);
+            }
+        }
+
+        size_t _Young_scan = 0;
+        size_t _Old_scan = 0;
+        while (_Young_scan < _Survivors.size() || _Old_scan < _Promoted.size()) {
+            for (; _Young_scan < _Survivors.size(); ++_Young_scan) {
+                const heap_ref _First = _Evacuate(_Survivors[_Young_scan].first);
+                _Survivors[_Young_scan].first = _First;
+                const heap_ref _Second = _Evacuate(_Survivors[_Young_scan].second);
+                _Survivors[_Young_scan].second = _Second;
+            }
+
+            for (; _Old_scan < _Promoted.size(); ++_Old_scan) {
+                _Scan_tenured(_Promoted[_Old_scan]);
+            }
+        }
+
+        _Nursery.swap(_Survivors);
+        _Survivors.clear();
+        _Young_marked = false; // the copies are not
+    }
+
+    void _Start_major()
+    { // the snapshot: the roots and the young cells they reach at this moment, the tenured cells
+      // of the root stacks follow in steps; their young ones are all past the last minor scan
+        const auto _Start = std::chrono::steady_clock::now();
+        _Phase = _Major_phase::_Marking;
+        _Unpaced = 0;
+        if (_Young_marked) { // by the last major collection, since the last minor one
+            for (heap_cell& _Young : _Nursery) {
+                _Young.marked = 0;
+            }
+
+            _Young_marked = false;
+        }
+
+        _Visit_roots([this](heap_ref& _Ref) { _Shade(_Ref); });
+        for (heap_root_stack* const _Stack : _Root_stacks) {
+            _Stack->_Mark_pos = 0;
+            _Stack->_Mark_end = _Stack->size();
+            for (size_t _Idx = std::min(_Stack->_Low, _Stack->_Old_below); _Idx < _Stack->size(); ++_Idx) {
+                if (_Is_young(_Stack->_Refs[_Idx])) {
+                    _Shade(_Stack->_Refs[_Idx]);
+                }
+            }
+        }
+
+        ++_Stats.major_steps;
+        _Finish(_Start, _Stats.max_major_pause_ns);
+    }
+
+    void _Major_step(size_t _Budget)
+    {
+        const auto _Start = std::chrono::steady_clock::now();
+        if (_Phase == _Major_phase::_Marking) {
+            _Mark(_Budget);
+        } else if (_Phase == _Major_phase::_Sweeping) {
+            _Sweep(_Budget);
+        }
+
+        ++_Stats.major_steps;
+        _Finish(_Start, _Stats.max_major_pause_ns);
+    }
+
+    void _Mark(size_t& _Budget)
+    {
+        for (heap_root_stack* const _Stack : _Root_stacks) {
+            for (; _Stack->_Mark_pos < _Stack->_Mark_end && _Budget != 0; --_Budget) {
+                _Shade(_Stack->_Refs[_Stack->_Mark_pos++]);
+            }
+        }
+
+        for (; !_Mark_stack.empty() && _Budget != 0; --_Budget) {
+            const heap_cell& _Marked = _Tenured_at(_Mark_stack.back());
+            _Mark_stack.pop_back();
+            _Shade(_Marked.first);
+            _Shade(_Marked.second);
+        }
+
+        if (_Budget == 0) {
+            return;
+        }
+
+        for (heap_root_stack* const _Stack : _Root_stacks) {
+            if (_Stack->_Mark_pos < _Stack->_Mark_end) {
+                return;
+            }
+
+            _Stack->_Mark_end = 0;
+        }
+
+        _Phase = _Major_phase::_Sweeping;
+        _Sweep_pos = 0;
+        _Sweep_end = _Tenured_size;
+        _Sweep(_Budget);
+    }
+
+    void _Sweep(size_t& _Budget) noexcept
+    { // a whole block at a time, which is released if nothing in it is alive
+        while (_Sweep_pos < _Sweep_end && _Budget != 0) {
+            const size_t _Block = _Sweep_pos >> _Block_bits;
+            const size_t _Block_end = std::min(_Sweep_pos + _Block_cells, _Sweep_end);
+            _Budget -= std::min(_Budget, _Block_end - _Sweep_pos);
+            if (!_Tenured_blocks[_Block]) {
+                _Sweep_pos = _Block_end;
+                continue;
+            }
+
+            // nothing promoted into the block past the end of the sweep
+            bool _Empty = _Block_end == _Sweep_pos + _Block_cells || _Tenured_size == _Block_end;
+            for (; _Sweep_pos < _Block_end; ++_Sweep_pos) {
+                heap_cell& _Target = _Tenured_at(static_cast<heap_ref>(_Sweep_pos));
+                if (_Target.tag == free_tag) {
+                    continue;
+                }
+
+                if (_Target.marked != 0) {
+                    _Target.marked = 0;
+                    _Empty = false;
+                    continue;
+                }
+
+                _Link(static_cast<heap_ref>(_Sweep_pos));
+                --_Tenured_used;
+                ++_Stats.freed;
+            }
+
+            if (_Empty) {
+                _Release_block(_Block);
+            }
+        }
+
+        if (_Sweep_pos >= _Sweep_end) {
+            _Phase = _Major_phase::_Idle;
+            _Major_limit = std::max(_Options.tenured_cells, _Tenured_used * _Options.tenured_growth);
+            ++_Stats.major_collections;
+        }
+    }
+
+    void _Finish(std::chrono::steady_clock::time_point _Start, std::uint64_t& _Max_pause) noexcept
+    {
+        const auto _Pause = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - _Start).count());
+        _Stats.pause_ns += _Pause;
+        _Max_pause = std::max(_Max_pause, _Pause);
+        if (_Pause > 1000000) {
+            ++_Stats.slow_pauses;
+        }
+
+        _Stats.peak_reserved_bytes = std::max(_Stats.peak_reserved_bytes, reserved_bytes());
+    }
+
+    heap_options _Options;
+    heap_stats _Stats;
+    size_t _Major_limit = 0;
+    size_t _Tenured_used = 0;    // tenured cells not in the free list
+    bool _Step_due = false;      // a major step at the next safe point halfway through the nursery
+    bool _Young_marked = false;
+    _Major_phase _Phase = _Major_phase::_Idle;
+    size_t _Unpaced = 0;         // cells promoted since the last major step
+    size_t _Sweep_pos = 0;
+    size_t _Sweep_end = 0;       // cells promoted past it are not swept this time
+    heap_ref _Free = null_heap_ref; // tenured free list
+    std::vector<heap_cell> _Nursery;
+    std::vector<heap_cell> _Survivors;
+    std::vector<std::unique_ptr<heap_cell[]>> _Tenured_blocks; // null where released
+    std::vector<size_t> _Empty_blocks; // released below the top, to reuse before growing
+    size_t _Block_count = 0;           // blocks allocated
+    size_t _Tenured_size = 0;          // cells handed out by the blocks, free ones included
+    std::vector<heap_ref> _Promoted;   // tenured indices, the queue of the minor collection
+    std::vector<heap_ref> _Remembered; // tenured indices
+    std::vector<heap_ref> _Old_remembered;
+    std::vector<heap_ref> _Mark_stack; // tenured indices, marked but their children not yet
+    std::vector<heap_ref> _Young_stack;
+    std::vector<heap_ref*> _Root_slots;
+    std::vector<std::vector<heap_ref>*> _Root_vectors;
+    std::vector<heap_root_stack*> _Root_stacks;
+};
+
+inline heap_root_stack::~heap_root_stack()
+{
+    if (_Heap != nullptr) {
+        _Heap->remove_roots(this);
+    }
+}
+
+inline void heap_root_stack::pop_back()
+{
+    const size_t _Idx = _Refs.size() - 1;
+    if (_Idx < _Mark_end) { // alive when marking began, and not yet marked if past _Mark_pos
+        if (_Idx >= _Mark_pos) {
+            _Heap->_Shade(_Refs[_Idx]);
+        }
+
+        _Mark_end = _Idx;
+    }
+
+    _Refs.pop_back();
+    if (_Idx < _Low) {
+        _Low = _Idx;
+    }
+}
+
+// CLASS heap_engine
+class heap_engine { // reusable, one per thread
+public:
+    explicit heap_engine(const heap_options& _Options = heap_options{}) : _Heap(_Options)
+    {
+        _Heap.add_root(&_Env);
+        _Heap.add_root(&_Value);
+        _Heap.add_roots(&_Frame_refs);
+        _Heap.add_roots(&_Pending);
+    }
+
+    heap_engine(const heap_engine&) = delete;
+    heap_engine& operator=(const heap_engine&) = delete;
+
+    term_ref normalize(term_arena& _Arena_, term_ref _Term
+        , const reduction_options& _Options, reduction_stats& _Stats_)
+    { // the same normal form and the same statistics as `nbe_engine::normalize`, and like it
+      // _Term unreduced when the fuel runs out
+        _Reset(); // whatever a call that threw left behind
+        _Arena = &_Arena_;
+        _Stats = &_Stats_;
+        _Fuel = _Options.fuel;
+        _Code.clear();
+        _Clear_names();
+        _In_scope.resize(_Arena->symbol_count(), 0);
+        _Innermost.resize(_Arena->symbol_count(), 0);
+
+        _Note_size(_Term);
+        _Free = free_variables(*_Arena, _Term);
+        for (const symbol _Name : _Free) {
+            _In_scope[_Name] = 1; // never reuse a free name for a binder
+        }
+
+        _Compiling = true;
+        const std::uint32_t _Root = _Compile_nbe_code(*_Arena, _Term, _Innermost, _Code);
+        _Compiling = false;
+        term_ref _Result;
+        try {
+            _Result = _Run(_Root);
+        } catch (const _Out_of_fuel&) {
+            _Stats->exhausted = true;
+            _Reset();
+            return _Term;
+        }
+
+        _Reset();
+        _Note_size(_Result);
+        return _Result;
+    }
+
+    term_ref normalize(term_arena& _Arena_, term_ref _Term)
+    {
+        reduction_stats _Stats_;
+        return normalize(_Arena_, _Term, reduction_options{}, _Stats_);
+    }
+
+    const term_heap& heap() const noexcept
+    {
+        return _Heap;
+    }
+
+private:
+    struct _Out_of_fuel {};
+
+    enum _Cell_tag : unsigned char {
+        _Thunk_tag,         // data: code, first: environment, second: value once forced
+        _Env_tag,           // first: thunk of de Bruijn index 0, second: the rest
+        _Spine_tag,         // first: thunk of the last argument, second: the ones before
+        _Closure_tag,       // data: code of the lambda, first: environment
+        _Neutral_level_tag, // data: de Bruijn level of the head, second: spine
+        _Neutral_free_tag   // data: name of the head, second: spine
+    };
+
+    enum class _Frame_kind : unsigned char {
+        _Arg,    // ref: thunk of an argument waiting for its function
+        _Update, // ref: thunk being forced
+        _Read,   // a: level, the returned value is read back
+        _Close,  // a: name, the term delivered is the body of a lambda
+        _Apply   // a: term so far, b: arguments left on `_Pending`, c: level
+    };
+
+    struct _Frame {
+        _Frame_kind kind;
+        std::uint32_t a;
+        std::uint32_t b;
+        std::uint32_t c;
+    };
+
+    enum class _Mode { _Eval, _Return, _Deliver };
+
+    void _Note_size(term_ref _Term) noexcept
+    {
+        if ((*_Arena)[_Term].size > _Stats->peak_size) {
+            _Stats->peak_size = (*_Arena)[_Term].size;
+        }
+    }
+
+    void _Take_step()
+    {
+        if (_Stats->steps >= _Fuel) {
+            throw _Out_of_fuel{};
+        }
+
+        ++_Stats->steps;
+    }
+
+    void _Reset()
+    {
+        _Heap.clear(); // first, so that no collection is under way to see the roots go
+        _Frames.clear();
+        _Frame_refs.clear();
+        _Pending.clear();
+        _Env = null_heap_ref;
+        _Value = null_heap_ref;
+    }
+
+    void _Push(_Frame_kind _Kind, heap_ref _Ref, std::uint32_t _A = 0, std::uint32_t _B = 0
+        , std::uint32_t _C = 0)
+    {
+        _Frames.push_back({_Kind, _A, _B, _C});
+        _Frame_refs.push_back(_Ref);
+    }
+
+    void _Pop()
+    {
+        _Frames.pop_back();
+        _Frame_refs.pop_back();
+    }
+
+    heap_ref _Lookup(heap_ref _At, std::uint32_t _Index) const noexcept
+    {
+        for (; _Index != 0; --_Index) {
+            _At = _Heap[_At].second;
+        }
+
+        return _Heap[_At].first;
+    }
+
+    void _Clear_names() noexcept
+    { // the tables by name stay zero between calls, so that a call costs what its own names
+      // cost and not every name the arena has seen; this undoes what the last call left
+        for (const symbol _Name : _Names) {
+            _In_scope[_Name] = 0;
+        }
+
+        for (const symbol _Name : _Free) {
+            _In_scope[_Name] = 0;
+        }
+
+        if (_Compiling) { // it threw half-way, with binders still set
+            std::fill(_Innermost.begin(), _Innermost.end(), 0);
+            _Compiling = false;
+        }
+
+        _Names.clear();
+        _Free.clear();
+    }
+
+    symbol _Bind_name(symbol _Param)
+    { // a name that no enclosing binder and no free variable uses
+        while (_Param < _In_scope.size() && _In_scope[_Param] != 0) {
+            _Param = _Arena->primed(_Param);
+        }
+
+        if (_Param >= _In_scope.size()) {
+            _In_scope.resize(_Arena->symbol_count(), 0);
+        }
+
+        ++_In_scope[_Param];
+        _Names.push_back(_Param);
+        return _Param;
+    }
+
+    bool _Force(heap_ref _Thunk)
+    { // true with the value in `_Value`, false with the thunk's code set up to run
+        const heap_cell& _Cell = _Heap[_Thunk];
+        if (_Cell.second != null_heap_ref) {
+            _Value = _Cell.second;
+            return true;
+        }
+
+        _Code_idx = _Cell.data;
+        _Env = _Cell.first;
+        _Push(_Frame_kind::_Update, _Thunk);
+        return false;
+    }
+
+    _Mode _Next_argument()
+    { // continues the `_Apply` frame on top
+        _Frame& _Top = _Frames.back();
+        if (_Top.b == 0) {
+            _Delivered = _Top.a;
+            _Pop();
+            return _Mode::_Deliver;
+        }
+
+        --_Top.b;
+        const std::uint32_t _Level = _Top.c;
+        const heap_ref _Thunk = _Pending.back();
+        _Pending.pop_back();
+        _Push(_Frame_kind::_Read, null_heap_ref, _Level);
+        return _Force(_Thunk) ? _Mode::_Return : _Mode::_Eval;
+    }
+
+    _Mode _Read_back(std::uint32_t _Level)
+    { // starts reading back `_Value`
+        const heap_cell _Cell = _Heap[_Value];
+        if (_Cell.tag == _Closure_tag) {
+            const _Nbe_code& _Lambda = _Code[_Cell.data];
+            _Push(_Frame_kind::_Close, null_heap_ref, _Bind_name(_Lambda.first));
+            const heap_ref _Fresh = _Heap.allocate(_Neutral_level_tag, _Level, null_heap_ref, null_heap_ref);
+            const heap_ref _Var = _Heap.allocate(_Thunk_tag, 0, null_heap_ref, _Fresh);
+            _Env = _Heap.allocate(_Env_tag, 0, _Var, _Cell.first);
+            _Push(_Frame_kind::_Read, null_heap_ref, _Level + 1);
+            _Code_idx = _Lambda.second;
+            return _Mode::_Eval;
+        }
+
+        const term_ref _Head = _Arena->variable(_Cell.tag == _Neutral_free_tag ? _Cell.data : _Names[_Cell.data]);
+        std::uint32_t _Count = 0;
+        for (heap_ref _Spine = _Cell.second; _Spine != null_heap_ref; _Spine = _Heap[_Spine].second) {
+            _Pending.push_back(_Heap[_Spine].first); // the last argument first, the first on top
+            ++_Count;
+        }
+
+        _Push(_Frame_kind::_Apply, null_heap_ref, _Head, _Count, _Level);
+        return _Next_argument();
+    }
+
+    term_ref _Close(symbol _Name, term_ref _Body)
+    { // lambda(x, f(x)) -> f, x is unique in scope so `occurs_free` is exact
+        const term_node& _Node = (*_Arena)[_Body];
+        if (_Node.kind == term_kind::application
+            && (*_Arena)[_Node.second].kind == term_kind::variable
+            && (*_Arena)[_Node.second].first == _Name
+            && !occurs_free(*_Arena, _Node.first, _Name)) {
+            if (_Stats->steps < _Fuel) {
+                ++_Stats->steps;
+                return _Node.first;
+            }
+
+            _Stats->exhausted = true; // what is read back is not eta-normal
+        }
+
+        return _Arena->lambda(_Name, _Body);
+    }
+
+    term_ref _Run(std::uint32_t _Root)
+    {
+        _Code_idx = _Root;
+        _Env = null_heap_ref;
+        _Push(_Frame_kind::_Read, null_heap_ref, 0);
+        _Mode _State = _Mode::_Eval;
+        for (;;) {
+            _Heap.collect_if_needed(); // everything alive is in `_Env`, `_Value` and the frames
+            switch (_State) {
+            case _Mode::_Eval:
+            {
+                const _Nbe_code _Node = _Code[_Code_idx];
+                switch (_Node.kind) {
+                case _Nbe_code_kind::bound:
+                    _State = _Force(_Lookup(_Env, _Node.first)) ? _Mode::_Return : _Mode::_Eval;
+                    break;
+                case _Nbe_code_kind::free:
+                    _Value = _Heap.allocate(_Neutral_free_tag, _Node.first, null_heap_ref, null_heap_ref);
+                    _State = _Mode::_Return;
+                    break;
+                case _Nbe_code_kind::lambda:
+                    if (!_Frames.empty() && _Frames.back().kind == _Frame_kind::_Arg) {
+                        _Take_step(); // continue with the body
+                        const heap_ref _Arg = _Frame_refs.back();
+                        _Pop();
+                        _Env = _Heap.allocate(_Env_tag, 0, _Arg, _Env);
+                        _Code_idx = _Node.second;
+                    } else {
+                        _Value = _Heap.allocate(_Closure_tag, _Code_idx, _Env, null_heap_ref);
+                        _State = _Mode::_Return;
+                    }
+                    break;
+                default:
+                {
+                    const _Nbe_code& _Arg = _Code[_Node.second];
+                    const heap_ref _Thunk = _Arg.kind == _Nbe_code_kind::bound
+                        ? _Lookup(_Env, _Arg.first) // share the thunk instead of wrapping it
+                        : _Heap.allocate(_Thunk_tag, _Node.second, _Env, null_heap_ref);
+                    _Push(_Frame_kind::_Arg, _Thunk);
+                    _Code_idx = _Node.first;
+                    break;
+                }
+                }
+
+                break;
+            }
+            case _Mode::_Return:
+            {
+                const _Frame _Top = _Frames.back();
+                const heap_ref _Ref = _Frame_refs.back();
+                if (_Top.kind == _Frame_kind::_Update) {
+                    _Heap.store_second(_Ref, _Value);
+                    _Heap.store_first(_Ref, null_heap_ref); // let the environment go
+                    _Pop();
+                } else if (_Top.kind == _Frame_kind::_Arg) {
+                    const heap_cell _Func = _Heap[_Value];
+                    if (_Func.tag == _Closure_tag) {
+                        _Take_step();
+                        _Pop();
+                        _Env = _Heap.allocate(_Env_tag, 0, _Ref, _Func.first);
+                        _Code_idx = _Code[_Func.data].second;
+                        _State = _Mode::_Eval;
+                    } else {
+                        const heap_ref _Spine = _Heap.allocate(_Spine_tag, 0, _Ref, _Func.second);
+                        _Value = _Heap.allocate(_Func.tag, _Func.data, null_heap_ref, _Spine);
+                        _Pop();
+                    }
+                } else { // _Read
+                    _Pop();
+                    _State = _Read_back(_Top.a);
+                }
+
+                break;
+            }
+            default: // _Deliver
+                if (_Frames.empty()) {
+                    return _Delivered;
+                }
+
+                if (_Frames.back().kind == _Frame_kind::_Close) {
+                    const symbol _Name = _Frames.back().a;
+                    _Pop();
+                    --_In_scope[_Name];
+                    _Names.pop_back();
+                    _Delivered = _Close(_Name, _Delivered);
+                } else { // _Apply
+                    _Frames.back().a = _Arena->application(_Frames.back().a, _Delivered);
+                    _State = _Next_argument();
+                }
+
+                break;
+            }
+        }
+    }
+
+    term_heap _Heap;
+    term_arena* _Arena = nullptr;
+    reduction_stats* _Stats = nullptr;
+    std::uint64_t _Fuel = 0;
+    std::vector<_Nbe_code> _Code;
+    std::vector<symbol> _Names;           // binder name by de Bruijn level
+    std::vector<std::uint32_t> _In_scope; // by name, binders using it plus one if free
+    std::vector<std::uint32_t> _Innermost;
+    std::vector<symbol> _Free; // of the term, marked in `_In_scope`
+    bool _Compiling = false;
+
+    // the machine: the code and environment being evaluated, the value being returned or
+    // the term being delivered, and the frames waiting for them
+    std::uint32_t _Code_idx = 0;
+    heap_ref _Env = null_heap_ref;
+    heap_ref _Value = null_heap_ref;
+    term_ref _Delivered = 0;
+    std::vector<_Frame> _Frames;
+    heap_root_stack _Frame_refs; // parallel to `_Frames`, null where a frame holds none
+    heap_root_stack _Pending;    // arguments of neutral values still to be read back
+};
+
+} // namespace runtime
+} // namespace nightly_lambda
+
+#endif // header guard
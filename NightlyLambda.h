@@ -7,8 +7,15 @@
 #define YUAN_NIGHTLY_LAMBDA
 
 #include "type_list.h"
+#include <cstdint>
 #include <iostream>
 
+#ifdef NIGHTLY_LAMBDA_CHECK_INTERNING
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#endif // NIGHTLY_LAMBDA_CHECK_INTERNING
+
 namespace nightly_lambda {
 
 // TYPE TAGS
@@ -18,6 +25,8 @@ class application_tag : has_secondary_tag {};
 class variable_tag : nightly_lambda_tag {};
 class lambda_tag : has_secondary_tag {};
 class subst_tag : has_secondary_tag {};
+class closure_tag : has_secondary_tag {};
+class fix_tag : has_secondary_tag {};
 
 // STRUCT TEMPLATE is_nightly_lambda
 template <class _Ty, class = void>
@@ -74,6 +83,28 @@ struct is_application<_Ty, std::void_t<typename _Ty::tag>>
 template <class _Ty>
 constexpr bool is_application_v = is_application<_Ty>::value;
 
+// STRUCT TEMPLATE is_closure
+template <class _Ty, class = void>
+struct is_closure : std::false_type {};
+
+template <class _Ty>
+struct is_closure<_Ty, std::void_t<typename _Ty::tag>>
+    : std::is_same<typename _Ty::tag, closure_tag> {};
+
+template <class _Ty>
+constexpr bool is_closure_v = is_closure<_Ty>::value;
+
+// STRUCT TEMPLATE is_fix
+template <class _Ty, class = void>
+struct is_fix : std::false_type {};
+
+template <class _Ty>
+struct is_fix<_Ty, std::void_t<typename _Ty::tag>>
+    : std::is_same<typename _Ty::tag, fix_tag> {};
+
+template <class _Ty>
+constexpr bool is_fix_v = is_fix<_Ty>::value;
+
 // FUNCTION TEMPLATE symb_eq
 template <class _Ty1, class _Ty2, std::enable_if_t<
     is_nightly_lambda_v<_Ty1> && is_nightly_lambda_v<_Ty2>, int> = 0>
@@ -85,6 +116,12 @@ constexpr bool symb_eq(const _Ty1&, const _Ty2&) noexcept
 template <class _FuncTy, class _ArgTy>
 class application_node;
 
+template <class _ExprTy, class _SubstList>
+class closure_node; // _SubstList is a std_ext::type_list of subst
+
+template <class _VarTy, class _ExprTy>
+class fix_node;
+
 // STRUCT TEMPLATE alpha_relation
 template <class _ExprTy, class _OldName, class _NewName>
 struct alpha_relation { // rename a formal parameter
@@ -130,6 +167,12 @@ struct _Full_reduction_impl<lambda_node<_VarTy, _ExprTy>> {
     using type = eta_reduction_t<_VarTy, _EvExpr>;
 };
 
+template <class _VarTy, class _ExprTy>
+struct _Full_reduction_impl<fix_node<_VarTy, _ExprTy>> { // never unrolled here, see `lazy_reduction`
+    using type = fix_node<typename _VarTy::self
+        , typename _Full_reduction_impl<typename _ExprTy::self>::type>;
+};
+
 template <class _FuncTy, class _ArgTy>
 struct _Full_reduction_impl<application_node<_FuncTy, _ArgTy>> {
     using _EvFunc = typename _Full_reduction_impl<typename _FuncTy::self>::type;
@@ -155,7 +198,7 @@ struct full_reduction { // !is_irreducible_v<_ExprTy>
 };
 
 template <class _ExprTy>
-struct full_reduction<_ExprTy, std::enable_if_t<is_irreducible_v<_ExprTy>>> {
+struct full_reduction<_ExprTy, std::enable_if_t<is_irreducible<_ExprTy>::value>> {
     using type = typename _ExprTy::self;
 };
 
@@ -184,6 +227,235 @@ struct _Unshadow {
     using remaining_names = _NameList;
 };
 
+// INTERNED TERMS
+// A node type nests the types of all its children, so the name of a big normal form is as
+// long as the term itself, and it ends up in every symbol and in the debug info that
+// mentions the term. `intern_t` maps a term to `interned_term<term_id<_Hash>>`, where
+// `_Hash` is an FNV-1a hash of its structure, and registers the structure under that ID by
+// friend injection. The interned type forwards everything to `self`, which is the
+// structural type again, so the reductions never see the difference. Within a translation
+// unit, two different terms with the same hash would define the same friend twice, which is
+// a compile error. Across translation units nothing compares them: each unit would give the
+// ID its own term, which violates the one definition rule, and the linker would silently keep
+// either. Defining NIGHTLY_LAMBDA_CHECK_INTERNING makes every interned term claim its ID
+// at startup together with a second hash, of its printed form, and aborts the program when
+// two units claim one ID for different terms. Debug builds of programs that intern terms in
+// more than one unit should define it.
+//
+// Defining NIGHTLY_LAMBDA_INTERN_TERMS makes `lambda`, `fix`, `operator()`, `operator[]`
+// and the `evaluate` functions return interned terms, and `operator<<` print them from a
+// string keyed by the ID.
+
+inline constexpr std::uint64_t _Fnv_offset_basis = 14695981039346656037ULL;
+inline constexpr std::uint64_t _Fnv_prime = 1099511628211ULL;
+
+constexpr std::uint64_t _Fnv_append(std::uint64_t _Hash, std::uint64_t _Val) noexcept
+{ // little endian, whatever the platform is
+    for (int _Idx = 0; _Idx != 8; ++_Idx) {
+        _Hash = (_Hash ^ ((_Val >> (8 * _Idx)) & 0xff)) * _Fnv_prime;
+    }
+
+    return _Hash;
+}
+
+template <char... _Chars>
+constexpr std::uint64_t _Fnv_chars(std::uint64_t _Hash, std_ext::char_sequence<_Chars...>) noexcept
+{
+    ((_Hash = (_Hash ^ static_cast<unsigned char>(_Chars)) * _Fnv_prime), ...);
+    return _Hash;
+}
+
+template <class _ExprTy>
+struct _Term_hash { // variable, by name
+    static constexpr std::uint64_t value = _Fnv_chars(_Fnv_append(_Fnv_offset_basis, 'v')
+        , typename _ExprTy::_Char_seq_rep{});
+};
+
+template <char _Kind, class... _Children>
+struct _Node_hash { // kind followed by the hashes of the children
+    static constexpr std::uint64_t value = [] {
+        std::uint64_t _Hash = _Fnv_append(_Fnv_offset_basis, static_cast<unsigned char>(_Kind));
+        ((_Hash = _Fnv_append(_Hash, _Term_hash<typename _Children::self>::value)), ...);
+        return _Hash;
+    }();
+};
+
+template <class _FuncTy, class _ArgTy>
+struct _Term_hash<application_node<_FuncTy, _ArgTy>> : _Node_hash<'a', _FuncTy, _ArgTy> {};
+
+template <class _VarTy, class _ExprTy>
+struct _Term_hash<lambda_node<_VarTy, _ExprTy>> : _Node_hash<'l', _VarTy, _ExprTy> {};
+
+template <class _VarTy, class _ExprTy>
+struct _Term_hash<fix_node<_VarTy, _ExprTy>> : _Node_hash<'f', _VarTy, _ExprTy> {};
+
+template <class _ExprTy, class... _Substs>
+struct _Term_hash<closure_node<_ExprTy, std_ext::type_list<_Substs...>>> {
+    static constexpr std::uint64_t value = [] {
+        std::uint64_t _Hash = _Fnv_append(_Term_hash<typename _ExprTy::self>::value, 'c');
+        ((_Hash = _Fnv_append(_Fnv_append(_Hash
+            , _Term_hash<typename _Substs::prim::self>::value)
+            , _Term_hash<typename _Substs::sec::self>::value)), ...);
+        return _Hash;
+    }();
+};
+
+// STRUCT TEMPLATE term_id
+template <std::uint64_t _Hash>
+struct term_id {
+    static constexpr std::uint64_t value = _Hash;
+};
+
+template <class _Ty>
+struct _Interned_type {
+    using type = _Ty;
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnon-template-friend"
+#endif // defined(__GNUC__) && !defined(__clang__)
+
+template <class _IdTy>
+struct _Interned_key { // the registry, one friend function per ID
+    friend constexpr auto _Interned_lookup(_Interned_key<_IdTy>) noexcept;
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif // defined(__GNUC__) && !defined(__clang__)
+
+template <class _IdTy, class _ExprTy>
+struct _Interned_entry { // instantiating it defines the friend of _Interned_key<_IdTy>
+    friend constexpr auto _Interned_lookup(_Interned_key<_IdTy>) noexcept
+    {
+        return _Interned_type<_ExprTy>{};
+    }
+};
+
+#ifdef NIGHTLY_LAMBDA_CHECK_INTERNING
+template <class _ExprTy>
+struct _Printed_hash { // independent of _Term_hash
+    static constexpr std::uint64_t value = _Fnv_chars(_Fnv_offset_basis, typename _ExprTy::_Char_seq_rep{});
+};
+
+inline bool _Claim_term_id(std::uint64_t _Id, std::uint64_t _Printed)
+{ // runs once per term and translation unit, before main
+    static std::unordered_map<std::uint64_t, std::uint64_t> _Claims;
+    if (_Claims.emplace(_Id, _Printed).first->second != _Printed) {
+        std::fprintf(stderr, "nightly_lambda: two different terms are interned as term_id<%llu>\n"
+            , static_cast<unsigned long long>(_Id));
+        std::abort();
+    }
+
+    return true;
+}
+
+template <std::uint64_t _Id, std::uint64_t _Printed>
+inline const bool _Term_id_claim = _Claim_term_id(_Id, _Printed);
+
+template <class _Ty>
+constexpr bool _Odr_use(const _Ty&) noexcept
+{ // instantiates the definition of its argument, and with it any dynamic initialization
+    return true;
+}
+#endif // NIGHTLY_LAMBDA_CHECK_INTERNING
+
+template <class _IdTy>
+class interned_term;
+
+// STRUCT TEMPLATE intern
+template <class _ExprTy>
+struct intern {
+    using id = term_id<_Term_hash<typename _ExprTy::self>::value>;
+    using type = std::conditional_t<sizeof(_Interned_entry<id, typename _ExprTy::self>) != 0
+#ifdef NIGHTLY_LAMBDA_CHECK_INTERNING
+        && _Odr_use(_Term_id_claim<id::value, _Printed_hash<typename _ExprTy::self>::value>)
+#endif // NIGHTLY_LAMBDA_CHECK_INTERNING
+        , interned_term<id>, void>;
+};
+
+template <class _ExprTy>
+using intern_t = typename intern<_ExprTy>::type;
+
+#ifdef NIGHTLY_LAMBDA_INTERN_TERMS
+template <class _ExprTy>
+using _Public_term_t = intern_t<_ExprTy>;
+#else // NIGHTLY_LAMBDA_INTERN_TERMS
+template <class _ExprTy>
+using _Public_term_t = typename _ExprTy::self;
+#endif // NIGHTLY_LAMBDA_INTERN_TERMS
+
+// CLASS TEMPLATE interned_term
+template <class _IdTy>
+class interned_term { // a registered term named by its ID only
+public:
+    using id = _IdTy;
+    using self = typename decltype(_Interned_lookup(_Interned_key<_IdTy>{}))::type;
+    using tag = typename self::tag;
+
+    template <class _Right>
+    constexpr bool symb_eq(const _Right&) const noexcept
+    {
+        return std::is_same_v<self, typename _Right::self>;
+    }
+
+    template <class _ArgTy, std::enable_if_t<is_nightly_lambda_v<_ArgTy>, int> = 0>
+    constexpr auto operator()(const _ArgTy&) const noexcept
+    {
+        return _Public_term_t<full_reduction_t<application_node<self, typename _ArgTy::self>>>{};
+    }
+
+    template <class _SubstTy, std::enable_if_t<
+        std::is_same_v<typename _SubstTy::tag, subst_tag>, int> = 0>
+    constexpr auto operator[](const _SubstTy&) const noexcept
+    {
+        return _Public_term_t<substitution_result_t<self, typename _SubstTy::self>>{};
+    }
+
+    template <class _OldName, class _NewName, std::enable_if_t<
+        is_variable_v<_OldName> && is_variable_v<_NewName>, int> = 0>
+    constexpr auto rename(const _OldName&, const _NewName&) const noexcept
+    {
+        return _Public_term_t<alpha_relation_t<self, _OldName, _NewName>>{};
+    }
+
+    template <class... _NewNames>
+    constexpr auto unshadow(const _NewNames&...) const noexcept
+    {
+        static_assert(std::conjunction_v<is_variable<_NewNames>...>, "invalid args");
+        return _Public_term_t<typename _Unshadow<self, std_ext::type_list<_NewNames...>>::type>{};
+    }
+};
+
+// STRUCT TEMPLATE is_interned
+template <class _Ty>
+struct is_interned : std::false_type {};
+
+template <class _IdTy>
+struct is_interned<interned_term<_IdTy>> : std::true_type {};
+
+template <class _Ty>
+constexpr bool is_interned_v = is_interned<_Ty>::value;
+
+template <size_t _Size>
+struct _Name_buffer {
+    char data[_Size];
+};
+
+template <char... _Chars>
+constexpr _Name_buffer<sizeof...(_Chars) + 1> _Make_name_buffer(std_ext::char_sequence<_Chars...>)
+    noexcept
+{
+    return {{_Chars..., 0}}; // trailing 0
+}
+
+template <class _IdTy>
+struct _Interned_name { // the string is keyed by the ID, not by its characters
+    static constexpr auto value = _Make_name_buffer(
+        typename interned_term<_IdTy>::self::_Char_seq_rep{});
+};
+
 // CLASS TEMPLATE _Node_base
 template <class _Self>
 class _Node_base {
@@ -201,28 +473,28 @@ public:
     template <class _ArgTy, std::enable_if_t<is_nightly_lambda_v<_ArgTy>, int> = 0>
     constexpr auto operator()(const _ArgTy&) const noexcept
     {
-        return full_reduction_t<application_node<self, typename _ArgTy::self>>{};
+        return _Public_term_t<full_reduction_t<application_node<self, typename _ArgTy::self>>>{};
     }
 
     template <class _SubstTy, std::enable_if_t<
         std::is_same_v<typename _SubstTy::tag, subst_tag>, int> = 0>
     constexpr auto operator[](const _SubstTy& _Subst) const noexcept
     {
-        return substitution_result_t<self, typename _SubstTy::self>{};
+        return _Public_term_t<substitution_result_t<self, typename _SubstTy::self>>{};
     }
 
     template <class _OldName, class _NewName, std::enable_if_t<
         is_variable_v<_OldName> && is_variable_v<_NewName>, int> = 0>
     constexpr auto rename(const _OldName&, const _NewName&) const noexcept
     {
-        return alpha_relation_t<self, _OldName, _NewName>{};
+        return _Public_term_t<alpha_relation_t<self, _OldName, _NewName>>{};
     }
 
     template <class... _NewNames>
     constexpr auto unshadow(const _NewNames&...) const noexcept
     {
         static_assert(std::conjunction_v<is_variable<_NewNames>...>, "invalid args");
-        return typename _Unshadow<self, std_ext::type_list<_NewNames...>>::type{};
+        return _Public_term_t<typename _Unshadow<self, std_ext::type_list<_NewNames...>>::type>{};
     }
 };
 
@@ -246,32 +518,32 @@ public:
 };
 
 namespace names {
-constexpr variable_node<0> a;
-constexpr variable_node<1> b;
-constexpr variable_node<2> c;
-constexpr variable_node<3> d;
-constexpr variable_node<4> e;
-constexpr variable_node<5> f;
-constexpr variable_node<6> g;
-constexpr variable_node<7> h;
-constexpr variable_node<8> i;
-constexpr variable_node<9> j;
-constexpr variable_node<10> k;
-constexpr variable_node<11> l;
-constexpr variable_node<12> m;
-constexpr variable_node<13> n;
-constexpr variable_node<14> o;
-constexpr variable_node<15> p;
-constexpr variable_node<16> q;
-constexpr variable_node<17> r;
-constexpr variable_node<18> s;
-constexpr variable_node<19> t;
-constexpr variable_node<20> u;
-constexpr variable_node<21> v;
-constexpr variable_node<22> w;
-constexpr variable_node<23> x;
-constexpr variable_node<24> y;
-constexpr variable_node<25> z;
+inline constexpr variable_node<0> a;
+inline constexpr variable_node<1> b;
+inline constexpr variable_node<2> c;
+inline constexpr variable_node<3> d;
+inline constexpr variable_node<4> e;
+inline constexpr variable_node<5> f;
+inline constexpr variable_node<6> g;
+inline constexpr variable_node<7> h;
+inline constexpr variable_node<8> i;
+inline constexpr variable_node<9> j;
+inline constexpr variable_node<10> k;
+inline constexpr variable_node<11> l;
+inline constexpr variable_node<12> m;
+inline constexpr variable_node<13> n;
+inline constexpr variable_node<14> o;
+inline constexpr variable_node<15> p;
+inline constexpr variable_node<16> q;
+inline constexpr variable_node<17> r;
+inline constexpr variable_node<18> s;
+inline constexpr variable_node<19> t;
+inline constexpr variable_node<20> u;
+inline constexpr variable_node<21> v;
+inline constexpr variable_node<22> w;
+inline constexpr variable_node<23> x;
+inline constexpr variable_node<24> y;
+inline constexpr variable_node<25> z;
 }
 
 // CLASS TEMPLATE shadowed
@@ -294,31 +566,6 @@ struct is_shadowed<shadowed<_VarTy>> : std::true_type {};
 template <class _Ty>
 constexpr bool is_shadowed_v = is_shadowed<_Ty>::value;
 
-// IMPL _Unshadow FOR lambda
-template <class _VarTy, class _ExprTy, class _First, class... _Rest>
-struct _Unshadow<lambda_node<shadowed<_VarTy>, _ExprTy>
-    , std_ext::type_list<_First, _Rest...>>
-{
-    static constexpr bool has_effect = true;
-    using type = alpha_relation_t<_ExprTy, shadowed<_VarTy>, _First>;
-    using remaining_names = _Unshadow<type, std_ext::type_list<_Rest...>>;
-};
-
-// IMPL _Unshadow FOR application
-template <class _FuncTy, class _ArgTy, class _First, class... _Rest>
-struct _Unshadow<application_node<_FuncTy, _ArgTy>, std_ext::type_list<_First, _Rest...>>
-{
-    using _UnshadowFunc = _Unshadow<typename _FuncTy::self, std_ext::type_list<_First, _Rest...>>;
-    using _FuncResult = typename _UnshadowFunc::type;
-    using _FuncRem = typename _UnshadowFunc::remaining_names;
-    using _UnshadowArg = _Unshadow<typename _ArgTy::self, _FuncRem>;
-    using _ArgResult = typename _UnshadowArg::type;
-    
-    using type = application_node<_FuncResult, _ArgResult>;
-    using remaining_names = typename _UnshadowArg::remaining_names;
-    static constexpr bool has_effect = _UnshadowFunc::has_effect || _UnshadowArg::has_effect;
-};
-
 template <template <class _Ty1, class _Ty2> class _Self, class _First, class _Second>
 class _Binary_node_base : public _Node_base<_Self<_First, _Second>> {
 public:
@@ -337,9 +584,9 @@ public:
 
     using _Char_seq_rep = std_ext::concat_integer_sequences<char
         , std_ext::char_sequence<'('>
-        , typename _FuncTy::_Char_seq_rep
+        , typename _FuncTy::self::_Char_seq_rep
         , std_ext::char_sequence<' '>
-        , typename _ArgTy::_Char_seq_rep
+        , typename _ArgTy::self::_Char_seq_rep
         , std_ext::char_sequence<')'>>;
 };
 
@@ -358,12 +605,52 @@ public:
 
     using _Char_seq_rep = std_ext::concat_integer_sequences<char
         , std_ext::char_sequence<'[','l','a','m','b','d','a',' '>
-        , typename _VarTy::_Char_seq_rep
+        , typename _VarTy::self::_Char_seq_rep
+        , std_ext::char_sequence<'.', ' '>
+        , typename _ExprTy::self::_Char_seq_rep
+        , std_ext::char_sequence<']'>>;
+};
+
+// CLASS TEMPLATE fix_node
+template <class _VarTy, class _ExprTy>
+class fix_node : public _Binary_node_base<fix_node, _VarTy, _ExprTy> {
+public:
+    using tag = fix_tag;
+
+    using _Char_seq_rep = std_ext::concat_integer_sequences<char
+        , std_ext::char_sequence<'[','f','i','x',' '>
+        , typename _VarTy::self::_Char_seq_rep
         , std_ext::char_sequence<'.', ' '>
-        , typename _ExprTy::_Char_seq_rep
+        , typename _ExprTy::self::_Char_seq_rep
         , std_ext::char_sequence<']'>>;
 };
 
+template <class _SubstTy>
+struct _Subst_rep { // [x <= a]
+    using type = std_ext::concat_integer_sequences<char
+        , std_ext::char_sequence<'['>
+        , typename _SubstTy::prim::self::_Char_seq_rep
+        , std_ext::char_sequence<' ', '<', '=', ' '>
+        , typename _SubstTy::sec::self::_Char_seq_rep
+        , std_ext::char_sequence<']'>>;
+};
+
+// CLASS TEMPLATE closure_node
+template <class _ExprTy, class... _Substs>
+class closure_node<_ExprTy, std_ext::type_list<_Substs...>>
+    : public _Node_base<closure_node<_ExprTy, std_ext::type_list<_Substs...>>>
+{ // a[x <= b][y <= c], substitutions that have not been carried out yet, applied left to right
+public:
+    using tag = closure_tag;
+
+    using prim = _ExprTy;
+    using sec = std_ext::type_list<_Substs...>;
+
+    using _Char_seq_rep = std_ext::concat_integer_sequences<char
+        , typename _ExprTy::self::_Char_seq_rep, std_ext::char_sequence<>
+        , typename _Subst_rep<_Substs>::type...>;
+};
+
 // FUNCTION TEMPLATE operator<= (make substitution)
 template <class _VarTy, class _ExprTy, std::enable_if_t<
     is_nightly_lambda_v<_ExprTy>, int> = 0>
@@ -372,6 +659,80 @@ inline constexpr auto operator<=(const _VarTy&, const _ExprTy&) noexcept
     return subst<_VarTy, _ExprTy>{};
 }
 
+template <template <class, class> class _Binder, class _VarTy, class _ExprTy, class _NameList>
+struct _Unshadow_binder { // binder(x, a) -> binder(x, a unshadowed)
+    using _Unshadow_body = _Unshadow<_ExprTy, _NameList>;
+    using type = _Binder<_VarTy, typename _Unshadow_body::type>;
+    using remaining_names = typename _Unshadow_body::remaining_names;
+    static constexpr bool has_effect = _Unshadow_body::has_effect;
+};
+
+template <template <class, class> class _Binder, class _VarTy, class _ExprTy
+    , class _First, class... _Rest>
+struct _Unshadow_binder<_Binder, shadowed<_VarTy>, _ExprTy, std_ext::type_list<_First, _Rest...>>
+{ // binder(x', a) -> binder(y, a[x' <= y] unshadowed with the names after y)
+    using _Unshadow_body = _Unshadow<substitution_result_t<_ExprTy
+        , subst<shadowed<_VarTy>, typename _First::self>>, std_ext::type_list<_Rest...>>;
+    using type = _Binder<typename _First::self, typename _Unshadow_body::type>;
+    using remaining_names = typename _Unshadow_body::remaining_names;
+    static constexpr bool has_effect = true;
+};
+
+// IMPL _Unshadow FOR lambda
+template <class _VarTy, class _ExprTy, class _NameList>
+struct _Unshadow<lambda_node<_VarTy, _ExprTy>, _NameList>
+    : _Unshadow_binder<lambda_node, typename _VarTy::self, typename _ExprTy::self, _NameList> {};
+
+// IMPL _Unshadow FOR fix
+template <class _VarTy, class _ExprTy, class _NameList>
+struct _Unshadow<fix_node<_VarTy, _ExprTy>, _NameList>
+    : _Unshadow_binder<fix_node, typename _VarTy::self, typename _ExprTy::self, _NameList> {};
+
+// IMPL _Unshadow FOR application
+template <class _FuncTy, class _ArgTy, class _First, class... _Rest>
+struct _Unshadow<application_node<_FuncTy, _ArgTy>, std_ext::type_list<_First, _Rest...>>
+{
+    using _UnshadowFunc = _Unshadow<typename _FuncTy::self, std_ext::type_list<_First, _Rest...>>;
+    using _FuncResult = typename _UnshadowFunc::type;
+    using _FuncRem = typename _UnshadowFunc::remaining_names;
+    using _UnshadowArg = _Unshadow<typename _ArgTy::self, _FuncRem>;
+    using _ArgResult = typename _UnshadowArg::type;
+    
+    using type = application_node<_FuncResult, _ArgResult>;
+    using remaining_names = typename _UnshadowArg::remaining_names;
+    static constexpr bool has_effect = _UnshadowFunc::has_effect || _UnshadowArg::has_effect;
+};
+
+template <class _Done, class _NameList, class... _Substs>
+struct _Unshadow_substs { // the values of pending substitutions, left to right
+    using type = _Done;
+    using remaining_names = _NameList;
+    static constexpr bool has_effect = false;
+};
+
+template <class... _Done, class _NameList, class _First, class... _Rest>
+struct _Unshadow_substs<std_ext::type_list<_Done...>, _NameList, _First, _Rest...> {
+    using _Unshadow_value = _Unshadow<typename _First::sec::self, _NameList>;
+    using _Next = _Unshadow_substs<std_ext::type_list<_Done...
+        , subst<typename _First::prim::self, typename _Unshadow_value::type>>
+        , typename _Unshadow_value::remaining_names, _Rest...>;
+    using type = typename _Next::type;
+    using remaining_names = typename _Next::remaining_names;
+    static constexpr bool has_effect = _Unshadow_value::has_effect || _Next::has_effect;
+};
+
+// IMPL _Unshadow FOR closure
+template <class _ExprTy, class... _Substs, class _NameList>
+struct _Unshadow<closure_node<_ExprTy, std_ext::type_list<_Substs...>>, _NameList>
+{ // a[x <= b] -> a unshadowed[x <= b unshadowed with the names left]
+    using _Unshadow_body = _Unshadow<typename _ExprTy::self, _NameList>;
+    using _Unshadow_values = _Unshadow_substs<std_ext::type_list<>
+        , typename _Unshadow_body::remaining_names, _Substs...>;
+    using type = closure_node<typename _Unshadow_body::type, typename _Unshadow_values::type>;
+    using remaining_names = typename _Unshadow_values::remaining_names;
+    static constexpr bool has_effect = _Unshadow_body::has_effect || _Unshadow_values::has_effect;
+};
+
 // STRUCT TEMPLATE free_variables
 template <class _ExprTy>
 struct free_variables {
@@ -386,36 +747,96 @@ struct free_variables<lambda_node<_VarTy, _ExprTy>> {
         ::template remove_completely<typename _VarTy::self>;
 };
 
+// IMPL free_variables FOR fix
+template <class _VarTy, class _ExprTy>
+struct free_variables<fix_node<_VarTy, _ExprTy>> : free_variables<lambda_node<_VarTy, _ExprTy>> {};
+
 // IMPL free_variables FOR application
 template <class _FuncTy, class _ArgTy>
 struct free_variables<application_node<_FuncTy, _ArgTy>> {
     using _FuncFV = typename free_variables<typename _FuncTy::self>::type;
     using _ArgFV = typename free_variables<typename _ArgTy::self>::type;
     using type = typename _FuncFV::template concat<_ArgFV>
-        ::template remove_duplicates;
+        ::remove_duplicates;
 };
 
 template <class _ExprTy>
 using free_variables_t = typename free_variables<typename _ExprTy::self>::type;
 
+template <class _FreeVars, class... _Substs>
+struct _Closure_free_variables { // no substitution left
+    using type = _FreeVars;
+};
+
+template <class _FreeVars, class _First, class... _Rest>
+struct _Closure_free_variables<_FreeVars, _First, _Rest...>
+{ // a{x}[x <= b] -> a{} + b{}, a{}[x <= b] -> a{}
+    using _Var = typename _First::prim::self;
+    using _Next = std::conditional_t<_FreeVars::template contains<_Var>
+        , typename _FreeVars::template remove_completely<_Var>
+            ::template concat<free_variables_t<typename _First::sec>>::remove_duplicates
+        , _FreeVars>;
+    using type = typename _Closure_free_variables<_Next, _Rest...>::type;
+};
+
+// IMPL free_variables FOR closure
+template <class _ExprTy, class... _Substs>
+struct free_variables<closure_node<_ExprTy, std_ext::type_list<_Substs...>>> {
+    using type = typename _Closure_free_variables<free_variables_t<_ExprTy>, _Substs...>::type;
+};
+
+template <class _VarTy, class _Avoid, bool = _Avoid::template contains<_VarTy>>
+struct _Fresh_name { // x, x', x''... whichever is not in _Avoid
+    using type = _VarTy;
+};
+
+template <class _VarTy, class _Avoid>
+struct _Fresh_name<_VarTy, _Avoid, true> {
+    using type = typename _Fresh_name<shadowed<_VarTy>, _Avoid>::type;
+};
+
+template <template <class, class> class _Binder, class _Param, class _ExprTy, class _SubstTy
+    , class = void>
+struct _Binder_substitution { // lambda(y, a)[x <= b{}] -> lambda(y, a[x <= b])
+    static constexpr bool has_effect = false;
+    using type = _Binder<_Param, substitution_result_t<_ExprTy, _SubstTy>>;
+};
+
+template <template <class, class> class _Binder, class _Param, class _ExprTy, class _SubstTy>
+struct _Binder_substitution<_Binder, _Param, _ExprTy, _SubstTy, std::enable_if_t<
+    std::is_same_v<typename _SubstTy::prim::self, _Param>>>
+{ // lambda(x, a)[x <= b] -> lambda(x, a)
+    static constexpr bool has_effect = true;
+    using type = _Binder<_Param, _ExprTy>;
+};
+
+template <template <class, class> class _Binder, class _Param, class _ExprTy, class _SubstTy>
+struct _Binder_substitution<_Binder, _Param, _ExprTy, _SubstTy, std::enable_if_t<
+    !std::is_same_v<typename _SubstTy::prim::self, _Param>
+    && free_variables_t<typename _SubstTy::sec>::template contains<_Param>>>
+{ // lambda(y, a)[x <= b{y}] -> lambda(y', a[y <= y'][x <= b]) // protect inner y
+    static constexpr bool has_effect = false;
+    using _Avoid = typename free_variables_t<typename _SubstTy::sec>
+        ::template concat<free_variables_t<_ExprTy>>::template append<typename _SubstTy::prim::self>;
+    using _NewParam = typename _Fresh_name<shadowed<_Param>, _Avoid>::type;
+    using type = _Binder<_NewParam, substitution_result_t<
+        substitution_result_t<_ExprTy, subst<_Param, _NewParam>>, _SubstTy>>;
+};
+
 // IMPL substitution_result FOR lambda
 template <class _VarTy, class _ExprTy, class _SubstTy>
 struct substitution_result<lambda_node<_VarTy, _ExprTy>, _SubstTy>
+    : _Binder_substitution<lambda_node, typename _VarTy::self, typename _ExprTy::self, _SubstTy>
 { // lambda(x, a)[x <= b] -> lambda(x, a);
   // lambda(y, a)[x <= b{}] -> lambda(y, a[x <= b])
   // lambda(y, a)[x <= b{y}] -> lambda(y', a[y <= y'][x <= b]) // protect inner y
-    using _SubstFreeVars = free_variables_t<typename _SubstTy::sec>;
-    using _Param = typename _VarTy::self;
-    using _ShadowParamIfNeeded = std::conditional_t<_SubstFreeVars::template contains<_Param>
-        , shadowed<_Param>, _Param>;
-        
-    static constexpr bool has_effect = std::is_same_v<
-        typename _VarTy::self, typename _SubstTy::prim::self>;
-        
-    using type = std::conditional_t<has_effect
-            , typename lambda_node<typename _VarTy::self, typename _ExprTy::self>
-            , lambda_node<_ShadowParamIfNeeded, substitution_result_t<
-                typename _ExprTy::self, _SubstTy>>>;
+};
+
+// IMPL substitution_result FOR fix
+template <class _VarTy, class _ExprTy, class _SubstTy>
+struct substitution_result<fix_node<_VarTy, _ExprTy>, _SubstTy>
+    : _Binder_substitution<fix_node, typename _VarTy::self, typename _ExprTy::self, _SubstTy>
+{ // fix(f, a)[f <= b] -> fix(f, a), otherwise as for lambda
 };
 
 // IMPL substitution_result FOR application
@@ -426,22 +847,40 @@ struct substitution_result<application_node<_FuncTy, _ArgTy>, _SubstTy>
         substitution_result_t<typename _ArgTy::self, _SubstTy>>;
 };
 
-// IMPL alpha_relation FOR lambda
-template <class _VarTy, class _ExprTy, class _OldName, class _NewName>
-struct alpha_relation<lambda_node<_VarTy, _ExprTy>, _OldName, _NewName> {
-    using _Reduce_body = alpha_relation<typename _ExprTy::self, _OldName, _NewName>;
+// IMPL substitution_result FOR closure
+template <class _ExprTy, class... _Substs, class _SubstTy>
+struct substitution_result<closure_node<_ExprTy, std_ext::type_list<_Substs...>>, _SubstTy>
+{ // a[s...][t] -> a[s..., t], substitutions compose instead of being carried out
+    static constexpr bool has_effect = true;
+    using type = closure_node<_ExprTy, std_ext::type_list<_Substs..., typename _SubstTy::self>>;
+};
+
+template <template <class, class> class _Binder, class _VarTy, class _ExprTy
+    , class _OldName, class _NewName>
+struct _Binder_alpha_relation {
+    using _Reduce_body = alpha_relation<_ExprTy, _OldName, _NewName>;
 
     using type = std::conditional_t<
-          std::is_same_v<typename _OldName::self, typename _VarTy::self>
-        , lambda_node<typename _NewName::self // lambda(x, a) -> lambda(y, a[x <= y])
-            , substitution_result_t<typename _ExprTy::self
-                , subst<typename _OldName::self, typename _NewName::self>>>
-        , lambda_node<typename _VarTy::self, typename _Reduce_body::type>>;
+          std::is_same_v<_OldName, _VarTy>
+        , _Binder<_NewName // lambda(x, a) -> lambda(y, a[x <= y])
+            , substitution_result_t<_ExprTy, subst<_OldName, _NewName>>>
+        , _Binder<_VarTy, typename _Reduce_body::type>>;
 
-    static constexpr bool has_effect = std::is_same_v<typename _OldName::self, typename _VarTy::self>
-        || _Reduce_body::has_effect;
+    static constexpr bool has_effect = std::is_same_v<_OldName, _VarTy> || _Reduce_body::has_effect;
 };
 
+// IMPL alpha_relation FOR lambda
+template <class _VarTy, class _ExprTy, class _OldName, class _NewName>
+struct alpha_relation<lambda_node<_VarTy, _ExprTy>, _OldName, _NewName>
+    : _Binder_alpha_relation<lambda_node, typename _VarTy::self, typename _ExprTy::self
+        , typename _OldName::self, typename _NewName::self> {};
+
+// IMPL alpha_relation FOR fix
+template <class _VarTy, class _ExprTy, class _OldName, class _NewName>
+struct alpha_relation<fix_node<_VarTy, _ExprTy>, _OldName, _NewName>
+    : _Binder_alpha_relation<fix_node, typename _VarTy::self, typename _ExprTy::self
+        , typename _OldName::self, typename _NewName::self> {};
+
 // IMPL alpha_relation FOR application
 template <class _FuncTy, class _ArgTy, class _OldName, class _NewName>
 struct alpha_relation<application_node<_FuncTy, _ArgTy>, _OldName, _NewName> {
@@ -458,6 +897,39 @@ struct alpha_relation<application_node<_FuncTy, _ArgTy>, _OldName, _NewName> {
     static constexpr bool has_effect = type1::has_effect || type2::has_effect;
 };
 
+template <class _Done, class _OldName, class _NewName, class... _Substs>
+struct _Alpha_relation_substs { // in the first substitution value that has such a binder
+    static constexpr bool has_effect = false;
+    using type = _Done;
+};
+
+template <class... _Done, class _OldName, class _NewName, class _First, class... _Rest>
+struct _Alpha_relation_substs<std_ext::type_list<_Done...>, _OldName, _NewName, _First, _Rest...> {
+    using _Rename_value = alpha_relation<typename _First::sec::self, _OldName, _NewName>;
+    using _Next = _Alpha_relation_substs<std_ext::type_list<_Done..., _First>, _OldName, _NewName, _Rest...>;
+
+    static constexpr bool has_effect = _Rename_value::has_effect || _Next::has_effect;
+    using type = std::conditional_t<_Rename_value::has_effect
+        , std_ext::type_list<_Done..., subst<typename _First::prim::self, typename _Rename_value::type>
+            , _Rest...>
+        , typename _Next::type>;
+};
+
+// IMPL alpha_relation FOR closure
+template <class _ExprTy, class... _Substs, class _OldName, class _NewName>
+struct alpha_relation<closure_node<_ExprTy, std_ext::type_list<_Substs...>>, _OldName, _NewName>
+{ // the first binder in a, or else in the substitution values, as for application
+    using _Rename_body = alpha_relation<typename _ExprTy::self
+        , typename _OldName::self, typename _NewName::self>;
+    using _Rename_values = _Alpha_relation_substs<std_ext::type_list<>
+        , typename _OldName::self, typename _NewName::self, _Substs...>;
+
+    using type = std::conditional_t<_Rename_body::has_effect
+        , closure_node<typename _Rename_body::type, std_ext::type_list<_Substs...>>
+        , closure_node<typename _ExprTy::self, typename _Rename_values::type>>;
+    static constexpr bool has_effect = _Rename_body::has_effect || _Rename_values::has_effect;
+};
+
 // IMPL beta_reduction FOR lambda
 template <class _VarTy, class _ExprTy, class _ArgTy>
 struct beta_reduction<lambda_node<_VarTy, _ExprTy>, _ArgTy>
@@ -478,17 +950,245 @@ struct eta_reduction<_VarTy, application_node<_FuncTy, _ArgTy>>
         typename _VarTy::self, typename _ArgTy::self>
         && !_FuncFreeVars::template contains<typename _VarTy::self>;
 
-    using type = std::conditional_t<has_effect, typename _FuncTy
+    using type = std::conditional_t<has_effect, typename _FuncTy::self
         , lambda_node<typename _VarTy::self
-            , typename application_node<typename _FuncTy::self, typename _ArgTy::self>>>;
+            , application_node<typename _FuncTy::self, typename _ArgTy::self>>>;
+};
+
+// LAZY REDUCTION
+// `beta_reduction` carries its substitution through the whole body at once. The templates
+// below leave it in a `closure_node` instead and push it down one node at a time, only
+// where the weak-head reduction has to look: under a lambda nothing is done at all, and an
+// argument that a Church boolean throws away is never copied. A closure that meets another
+// closure composes with it, and a closure reaching a variable is resolved by the first
+// matching substitution, whose result still has the substitutions after it pending.
+//
+// A `fix_node` is unrolled by the same reduction, and only when it is applied in head
+// position, so recursion costs as many unrollings as there are recursive calls. The eager
+// reduction leaves it alone; `fix(f, a)(b)` is reduced by `lazy_evaluate` only.
+
+template <class _FreeVars, class _Kept, class... _Substs>
+struct _Used_substs { // keeps the substitutions whose name is still free when they apply
+    using type = _Kept;
+};
+
+template <class _FreeVars, class... _Kept, class _First, class... _Rest>
+struct _Used_substs<_FreeVars, std_ext::type_list<_Kept...>, _First, _Rest...> {
+    static constexpr bool _Used = _FreeVars::template contains<typename _First::prim::self>;
+    using _Next = typename _Closure_free_variables<_FreeVars, _First>::type;
+    using type = typename _Used_substs<_Next, std::conditional_t<_Used
+        , std_ext::type_list<_Kept..., _First>, std_ext::type_list<_Kept...>>, _Rest...>::type;
+};
+
+template <class _ExprTy, class _SubstList>
+struct _Closure_or_expr { // a[s...] or just a if there is nothing to substitute
+    using type = closure_node<_ExprTy, _SubstList>;
+};
+
+template <class _ExprTy>
+struct _Closure_or_expr<_ExprTy, std_ext::type_list<>> {
+    using type = _ExprTy;
+};
+
+template <class _ExprTy, class _SubstList>
+struct _Make_closure;
+
+template <class _ExprTy, class... _Substs>
+struct _Make_closure<_ExprTy, std_ext::type_list<_Substs...>>
+{ // a[s...] without the substitutions that have nothing left to replace, so that closures
+  // which are bound to have the same result also have the same type
+    using type = typename _Closure_or_expr<_ExprTy, typename _Used_substs<
+        free_variables_t<_ExprTy>, std_ext::type_list<>, _Substs...>::type>::type;
+};
+
+template <class _ExprTy, class... _Inner, class... _Substs>
+struct _Make_closure<closure_node<_ExprTy, std_ext::type_list<_Inner...>>
+    , std_ext::type_list<_Substs...>>
+    : _Make_closure<_ExprTy, std_ext::type_list<_Inner..., _Substs...>> {}; // a[s][t] -> a[s, t]
+
+template <class _ExprTy, class _SubstList>
+using _Make_closure_t = typename _Make_closure<typename _ExprTy::self, _SubstList>::type;
+
+template <class _ExprTy, class _SubstList>
+struct _Push_closure; // one step of a[s...]
+
+template <class _VarTy, class _SubstList, class = void>
+struct _Push_variable { // x[y <= b][s...] -> x[s...]
+    using type = typename _VarTy::self;
+};
+
+template <class _VarTy, class _First, class... _Rest>
+struct _Push_variable<_VarTy, std_ext::type_list<_First, _Rest...>, std::enable_if_t<
+    !std::is_same_v<typename _VarTy::self, typename _First::prim::self>>>
+    : _Push_variable<_VarTy, std_ext::type_list<_Rest...>> {};
+
+template <class _VarTy, class _First, class... _Rest>
+struct _Push_variable<_VarTy, std_ext::type_list<_First, _Rest...>, std::enable_if_t<
+    std::is_same_v<typename _VarTy::self, typename _First::prim::self>>>
+{ // x[x <= b][s...] -> b[s...]
+    using type = _Make_closure_t<typename _First::sec, std_ext::type_list<_Rest...>>;
+};
+
+template <class _ExprTy, class _SubstList>
+struct _Push_closure { // variable
+    static_assert(is_variable_v<_ExprTy>, "invalid _ExprTy");
+    using type = typename _Push_variable<_ExprTy, _SubstList>::type;
+};
+
+template <class _FuncTy, class _ArgTy, class _SubstList>
+struct _Push_closure<application_node<_FuncTy, _ArgTy>, _SubstList>
+{ // f(a)[s] -> f[s](a[s])
+    using type = application_node<_Make_closure_t<_FuncTy, _SubstList>
+        , _Make_closure_t<_ArgTy, _SubstList>>;
+};
+
+template <class _ExprTy, class... _Inner, class _SubstList>
+struct _Push_closure<closure_node<_ExprTy, std_ext::type_list<_Inner...>>, _SubstList>
+    : _Push_closure<typename _ExprTy::self
+        , typename std_ext::type_list<_Inner...>::template concat<_SubstList>> {};
+
+template <template <class, class> class _Binder, class _Param, class _ExprTy, class _SubstTy
+    , class = void>
+struct _Push_into_binder { // lambda(y, a)[x <= b] -> lambda(y, a[x <= b])
+    using type = _Binder<_Param, _Make_closure_t<_ExprTy, std_ext::type_list<_SubstTy>>>;
+};
+
+template <template <class, class> class _Binder, class _Param, class _ExprTy, class _SubstTy>
+struct _Push_into_binder<_Binder, _Param, _ExprTy, _SubstTy, std::enable_if_t<
+    std::is_same_v<typename _SubstTy::prim::self, _Param>>>
+{ // lambda(x, a)[x <= b] -> lambda(x, a)
+    using type = _Binder<_Param, _ExprTy>;
+};
+
+template <template <class, class> class _Binder, class _Param, class _ExprTy, class _SubstTy>
+struct _Push_into_binder<_Binder, _Param, _ExprTy, _SubstTy, std::enable_if_t<
+    !std::is_same_v<typename _SubstTy::prim::self, _Param>
+    && free_variables_t<typename _SubstTy::sec>::template contains<_Param>>>
+{ // lambda(y, a)[x <= b{y}] -> lambda(y', a[y <= y'][x <= b])
+    using _Avoid = typename free_variables_t<typename _SubstTy::sec>
+        ::template concat<free_variables_t<_ExprTy>>::template append<typename _SubstTy::prim::self>;
+    using _NewParam = typename _Fresh_name<shadowed<_Param>, _Avoid>::type;
+    using type = _Binder<_NewParam
+        , _Make_closure_t<_ExprTy, std_ext::type_list<subst<_Param, _NewParam>, _SubstTy>>>;
+};
+
+template <class _BinderTy, class... _Substs>
+struct _Push_binder { // nothing left to push
+    using type = _BinderTy;
+};
+
+template <template <class, class> class _Binder, class _VarTy, class _ExprTy
+    , class _First, class... _Rest>
+struct _Push_binder<_Binder<_VarTy, _ExprTy>, _First, _Rest...>
+{ // one substitution at a time, since _First may bring in a name that a later one replaces
+    using type = typename _Push_binder<typename _Push_into_binder<_Binder
+        , typename _VarTy::self, typename _ExprTy::self, _First>::type, _Rest...>::type;
+};
+
+template <class _VarTy, class _ExprTy, class... _Substs>
+struct _Push_closure<lambda_node<_VarTy, _ExprTy>, std_ext::type_list<_Substs...>>
+    : _Push_binder<lambda_node<_VarTy, _ExprTy>, _Substs...> {};
+
+template <class _VarTy, class _ExprTy, class... _Substs>
+struct _Push_closure<fix_node<_VarTy, _ExprTy>, std_ext::type_list<_Substs...>>
+    : _Push_binder<fix_node<_VarTy, _ExprTy>, _Substs...> {};
+
+// IMPL _Full_reduction_impl FOR closure
+template <class _ExprTy, class _SubstList>
+struct _Full_reduction_impl<closure_node<_ExprTy, _SubstList>> {
+    using type = typename _Push_closure<typename _ExprTy::self, _SubstList>::type;
+};
+
+template <class _ExprTy>
+struct _Weak_head_impl { // variable, lambda or fix, which is only unrolled once it is applied
+    using type = typename _ExprTy::self;
+};
+
+template <class _HeadTy, class _ArgTy>
+struct _Weak_head_apply { // neutral head, the argument stays as it is
+    using type = application_node<_HeadTy, _ArgTy>;
+};
+
+template <class _VarTy, class _ExprTy, class _ArgTy>
+struct _Weak_head_apply<lambda_node<_VarTy, _ExprTy>, _ArgTy>
+{ // lambda(x, a)(b) -> a[x <= b], which is not carried out yet
+    using type = typename _Weak_head_impl<_Make_closure_t<_ExprTy
+        , std_ext::type_list<subst<typename _VarTy::self, _ArgTy>>>>::type;
+};
+
+template <class _VarTy, class _ExprTy, class _ArgTy>
+struct _Weak_head_apply<fix_node<_VarTy, _ExprTy>, _ArgTy>
+{ // fix(f, a)(b) -> a[f <= fix(f, a)](b), unrolled once because it is in head position
+    using _Unrolled = _Make_closure_t<_ExprTy
+        , std_ext::type_list<subst<typename _VarTy::self, fix_node<_VarTy, _ExprTy>>>>;
+    using type = typename _Weak_head_impl<application_node<_Unrolled, _ArgTy>>::type;
+};
+
+template <class _FuncTy, class _ArgTy>
+struct _Weak_head_impl<application_node<_FuncTy, _ArgTy>> {
+    using type = typename _Weak_head_apply<
+        typename _Weak_head_impl<typename _FuncTy::self>::type, typename _ArgTy::self>::type;
 };
 
+template <class _ExprTy, class _SubstList>
+struct _Weak_head_impl<closure_node<_ExprTy, _SubstList>> {
+    using type = typename _Weak_head_impl<
+        typename _Push_closure<typename _ExprTy::self, _SubstList>::type>::type;
+};
+
+// STRUCT TEMPLATE weak_head_reduction
+template <class _ExprTy>
+struct weak_head_reduction { // call by name; may leave closures under lambdas and in arguments
+    using type = typename _Weak_head_impl<typename _ExprTy::self>::type;
+};
+
+template <class _ExprTy>
+using weak_head_reduction_t = typename weak_head_reduction<_ExprTy>::type;
+
+template <class _ExprTy>
+struct _Lazy_normal;
+
+template <class _ExprTy>
+struct _Lazy_normal_whnf { // variable
+    using type = _ExprTy;
+};
+
+template <class _VarTy, class _ExprTy>
+struct _Lazy_normal_whnf<lambda_node<_VarTy, _ExprTy>> {
+    using type = eta_reduction_t<_VarTy, typename _Lazy_normal<typename _ExprTy::self>::type>;
+};
+
+template <class _VarTy, class _ExprTy>
+struct _Lazy_normal_whnf<fix_node<_VarTy, _ExprTy>> { // fix(f, a) that is never applied
+    using type = fix_node<_VarTy, typename _Lazy_normal<typename _ExprTy::self>::type>;
+};
+
+template <class _FuncTy, class _ArgTy>
+struct _Lazy_normal_whnf<application_node<_FuncTy, _ArgTy>> { // neutral head
+    using type = application_node<typename _Lazy_normal<typename _FuncTy::self>::type
+        , typename _Lazy_normal<typename _ArgTy::self>::type>;
+};
+
+template <class _ExprTy>
+struct _Lazy_normal {
+    using type = typename _Lazy_normal_whnf<weak_head_reduction_t<_ExprTy>>::type;
+};
+
+// STRUCT TEMPLATE lazy_reduction
+template <class _ExprTy>
+struct lazy_reduction { // normal order through closures; the normal form has no closures
+    using type = typename _Lazy_normal<typename _ExprTy::self>::type;
+};
+
+template <class _ExprTy>
+using lazy_reduction_t = typename lazy_reduction<_ExprTy>::type;
+
 // FUNCTION TEMPLATE lambda
 template <class _VarTy, class _ExprTy, std::enable_if_t<
     is_nightly_lambda_v<_ExprTy>, int> = 0>
 inline constexpr auto lambda(const _VarTy&, const _ExprTy&) noexcept
 {
-    return eta_reduction_t<_VarTy, _ExprTy>{};
+    return _Public_term_t<eta_reduction_t<_VarTy, _ExprTy>>{};
 }
 
 template <class _VarTy, class... _Args>
@@ -497,6 +1197,14 @@ constexpr auto lambda(const _VarTy& _FirstVar, const _Args&... _ConsecArgs) noex
     return lambda(_FirstVar, lambda(_ConsecArgs...));
 }
 
+// FUNCTION TEMPLATE fix
+template <class _VarTy, class _ExprTy, std::enable_if_t<
+    is_variable_v<_VarTy> && is_nightly_lambda_v<_ExprTy>, int> = 0>
+inline constexpr auto fix(const _VarTy&, const _ExprTy&) noexcept
+{ // fix(f, a) is a, in which f stands for fix(f, a) itself
+    return _Public_term_t<fix_node<typename _VarTy::self, typename _ExprTy::self>>{};
+}
+
 // FUNCTION TEMPLATE evaluate
 template <class _ExprTy, std::enable_if_t<is_nightly_lambda_v<_ExprTy>, int> = 0>
 inline constexpr auto evaluate(const _ExprTy&) noexcept
@@ -504,7 +1212,23 @@ inline constexpr auto evaluate(const _ExprTy&) noexcept
   // expression type by hand, bypassing the functions, it would be more convenient
   // to call the function `evaluate`.
 
-    return full_reduction_t<_ExprTy>{};
+    return _Public_term_t<full_reduction_t<_ExprTy>>{};
+}
+
+// FUNCTION TEMPLATE lazy_evaluate
+template <class _ExprTy, std::enable_if_t<is_nightly_lambda_v<_ExprTy>, int> = 0>
+inline constexpr auto lazy_evaluate(const _ExprTy&) noexcept
+{ // like `evaluate`, but substitutions are only carried out where the reduction needs them,
+  // and arguments that are thrown away are never reduced
+
+    return _Public_term_t<lazy_reduction_t<_ExprTy>>{};
+}
+
+// FUNCTION TEMPLATE weak_head_evaluate
+template <class _ExprTy, std::enable_if_t<is_nightly_lambda_v<_ExprTy>, int> = 0>
+inline constexpr auto weak_head_evaluate(const _ExprTy&) noexcept
+{
+    return _Public_term_t<weak_head_reduction_t<_ExprTy>>{};
 }
 
 // FUNCTION TEMPLATE full_simplify
@@ -518,7 +1242,11 @@ inline constexpr auto full_simplify(const _ExprTy& _Expr, const _NewNames&... _N
 template <class _ExprTy, std::enable_if_t<is_nightly_lambda_v<_ExprTy>, int> = 0>
 std::ostream& operator<<(std::ostream& _Lhs, const _ExprTy&)
 {
-    return (_Lhs << std_ext::to_string_constant<typename _ExprTy::_Char_seq_rep>::value);
+    if constexpr (is_interned_v<_ExprTy>) {
+        return (_Lhs << _Interned_name<typename _ExprTy::id>::value.data);
+    } else {
+        return (_Lhs << std_ext::to_string_constant<typename _ExprTy::_Char_seq_rep>::value);
+    }
 }
 
 } // namespace nightly_lambda
@@ -0,0 +1,364 @@
+// NightlyNative.h - implements the lowering of normal forms into native function objects,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// `lower` turns a closed term into a C++ function object with the same behaviour: every
+// `lambda_node` becomes a generic lambda that captures its environment by value, every
+// `application_node` becomes a call and every `variable_node` a `std::get` on that
+// environment. Nothing is left to do at runtime except what the term itself computes, so
+// an optimizing compiler inlines the whole object.
+//
+// Church numerals and booleans are recognized on the way and lowered into `church_constant`
+// and `church_bool`, which carry their count or value in their type and implement the
+// numeral and boolean behaviour natively. A numeral applied to `_Native_succ` is an addition
+// and a numeral applied to an iterated function multiplies the iteration count, so that
+// `to_size_t` reduces `lower(add)(church(a))(church(b))` to `a + b` and `lower(mul)` to
+// `a * b`. `church(n)` makes a `church_numeral`, whose count is only known at runtime; it can
+// iterate only a function whose result type is its argument type, as `_Native_succ` does,
+// and anything else is rejected by `static_assert`. A `church_constant`, as made by
+// `church<n>()`, also unrolls a function that changes the type on every application, so
+// `lower(pred)(church<3>())` and `lower(iszero)(church<3>())` work as the terms do.
+// The term `[lambda a. [lambda b. b]]` is both zero and false; it is lowered as
+// `church_constant<0>`, which selects its second argument just like false does.
+
+#pragma once
+#ifndef YUAN_NIGHTLY_NATIVE
+#define YUAN_NIGHTLY_NATIVE
+
+#include "NightlyLambda.h"
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace nightly_lambda {
+
+// STRUCT _Native_succ
+struct _Native_succ {
+    constexpr size_t operator()(size_t _Val) const noexcept
+    {
+        return _Val + 1;
+    }
+};
+
+// FUNCTION _Church_power
+constexpr size_t _Church_power(size_t _Base, size_t _Exponent) noexcept
+{
+    size_t _Result = 1;
+    for (size_t _Idx = 0; _Idx != _Exponent; ++_Idx) {
+        _Result *= _Base;
+    }
+
+    return _Result;
+}
+
+template <class _FuncTy, class _Ty, class = void>
+struct _Is_endomorphism : std::false_type {}; // _FuncTy maps _Ty to _Ty
+
+template <class _FuncTy, class _Ty>
+struct _Is_endomorphism<_FuncTy, _Ty, std::enable_if_t<std::is_invocable_v<const _FuncTy&, const _Ty&>>>
+    : std::is_same<std::decay_t<std::invoke_result_t<const _FuncTy&, const _Ty&>>, _Ty> {};
+
+// STRUCT TEMPLATE _Iterate
+template <class _FuncTy>
+struct _Iterate { // _Func applied _Count times, the count known at runtime
+    _FuncTy _Func;
+    size_t _Count;
+
+    template <class _Ty>
+    constexpr _Ty operator()(_Ty _Val) const
+    {
+        if constexpr (std::is_same_v<_FuncTy, _Native_succ> && std::is_arithmetic_v<_Ty>) {
+            return static_cast<_Ty>(_Val + _Count);
+        } else if constexpr (_Is_endomorphism<_FuncTy, _Ty>::value) {
+            for (size_t _Idx = 0; _Idx != _Count; ++_Idx) {
+                _Val = _Func(_Val);
+            }
+
+            return _Val;
+        } else {
+            static_assert(_Is_endomorphism<_FuncTy, _Ty>::value, "a church_numeral can only iterate"
+                " a function whose result type is its argument type, use church<n>() instead");
+            return _Val;
+        }
+    }
+};
+
+// STRUCT TEMPLATE _Unrolled
+template <class _FuncTy, size_t _Count>
+struct _Unrolled { // _Func applied _Count times, the count known at compile time
+    _FuncTy _Func;
+
+    template <class _Ty>
+    constexpr auto operator()(_Ty _Val) const
+    {
+        if constexpr (_Count == 0) {
+            return _Val;
+        } else if constexpr (std::is_same_v<_FuncTy, _Native_succ> && std::is_arithmetic_v<_Ty>) {
+            return static_cast<_Ty>(_Val + _Count);
+        } else if constexpr (_Is_endomorphism<_FuncTy, _Ty>::value) {
+            for (size_t _Idx = 0; _Idx != _Count; ++_Idx) {
+                _Val = _Func(_Val);
+            }
+
+            return _Val;
+        } else { // the type changes, unroll one application
+            return _Unrolled<_FuncTy, _Count - 1>{_Func}(_Func(_Val));
+        }
+    }
+};
+
+template <size_t _Val>
+struct church_constant;
+
+// STRUCT church_numeral
+struct church_numeral { // [lambda f. [lambda x. (f ... (f x))]] holding its count natively
+    size_t value;
+
+    constexpr church_numeral operator()(const church_numeral& _Other) const noexcept
+    { // n m -> m^n
+        return church_numeral{_Church_power(_Other.value, value)};
+    }
+
+    template <size_t _Other>
+    constexpr church_numeral operator()(church_constant<_Other>) const noexcept
+    {
+        return church_numeral{_Church_power(_Other, value)};
+    }
+
+    template <class _FuncTy>
+    constexpr _Iterate<_FuncTy> operator()(const _Iterate<_FuncTy>& _Func) const
+    { // n (f^k) -> f^(n * k)
+        return _Iterate<_FuncTy>{_Func._Func, value * _Func._Count};
+    }
+
+    template <class _FuncTy, size_t _Count>
+    constexpr _Iterate<_FuncTy> operator()(const _Unrolled<_FuncTy, _Count>& _Func) const
+    {
+        return _Iterate<_FuncTy>{_Func._Func, value * _Count};
+    }
+
+    template <class _FuncTy>
+    constexpr _Iterate<_FuncTy> operator()(_FuncTy _Func) const
+    {
+        return _Iterate<_FuncTy>{std::move(_Func), value};
+    }
+
+    constexpr operator size_t() const noexcept
+    {
+        return value;
+    }
+};
+
+// STRUCT TEMPLATE church_constant
+template <size_t _Val>
+struct church_constant { // a church_numeral whose count is part of its type
+    static constexpr size_t value = _Val;
+
+    constexpr church_numeral operator()(const church_numeral& _Other) const noexcept
+    { // n m -> m^n
+        return church_numeral{_Church_power(_Other.value, _Val)};
+    }
+
+    template <size_t _Other>
+    constexpr church_constant<_Church_power(_Other, _Val)> operator()(church_constant<_Other>) const noexcept
+    {
+        return {};
+    }
+
+    template <class _FuncTy>
+    constexpr _Iterate<_FuncTy> operator()(const _Iterate<_FuncTy>& _Func) const
+    { // n (f^k) -> f^(n * k)
+        return _Iterate<_FuncTy>{_Func._Func, _Val * _Func._Count};
+    }
+
+    template <class _FuncTy, size_t _Count>
+    constexpr _Unrolled<_FuncTy, _Val * _Count> operator()(const _Unrolled<_FuncTy, _Count>& _Func) const
+    {
+        return _Unrolled<_FuncTy, _Val * _Count>{_Func._Func};
+    }
+
+    template <class _FuncTy>
+    constexpr _Unrolled<_FuncTy, _Val> operator()(_FuncTy _Func) const
+    {
+        return _Unrolled<_FuncTy, _Val>{std::move(_Func)};
+    }
+
+    constexpr operator church_numeral() const noexcept
+    {
+        return church_numeral{_Val};
+    }
+
+    constexpr operator size_t() const noexcept
+    {
+        return _Val;
+    }
+};
+
+// STRUCT TEMPLATE church_bool
+template <bool _Val>
+struct church_bool; // false is the numeral zero, and is lowered as church_constant<0>
+
+template <>
+struct church_bool<true> { // [lambda a. [lambda b. a]] holding its value natively
+    static constexpr bool value = true;
+
+    template <class _Ty>
+    constexpr auto operator()(_Ty&& _True) const
+    {
+        return [_True = std::forward<_Ty>(_True)](auto&&) constexpr {
+            return _True;
+        };
+    }
+
+    constexpr operator bool() const noexcept
+    {
+        return true;
+    }
+};
+
+// FUNCTION church
+constexpr church_numeral church(size_t _Val) noexcept
+{
+    return church_numeral{_Val};
+}
+
+template <size_t _Val>
+constexpr church_constant<_Val> church() noexcept
+{
+    return {};
+}
+
+// FUNCTION TEMPLATE to_size_t
+template <class _Ty>
+constexpr size_t to_size_t(const _Ty& _Val)
+{ // reads a lowered Church numeral back as a native count
+    if constexpr (std::is_same_v<_Ty, church_numeral>) {
+        return _Val.value;
+    } else {
+        return static_cast<size_t>(_Val(_Native_succ{})(size_t{0}));
+    }
+}
+
+// FUNCTION TEMPLATE to_bool
+template <class _Ty>
+constexpr bool to_bool(const _Ty& _Val)
+{ // reads a lowered Church boolean back as a native bool
+    return static_cast<bool>(_Val(true)(false));
+}
+
+template <class _ExprTy>
+struct _Church_body_count { // f^n x -> n, given the names of f and x
+    static constexpr bool matches = false;
+};
+
+template <class _FTy, class _XTy, class _Body>
+struct _Church_count : _Church_body_count<_Body> {};
+
+template <class _FTy, class _XTy>
+struct _Church_count<_FTy, _XTy, _XTy> {
+    static constexpr bool matches = true;
+    static constexpr size_t value = 0;
+};
+
+template <class _FTy, class _XTy, class _ArgTy>
+struct _Church_count<_FTy, _XTy, application_node<_FTy, _ArgTy>> {
+    using _Inner = _Church_count<_FTy, _XTy, typename _ArgTy::self>;
+    static constexpr bool matches = _Inner::matches;
+    static constexpr size_t value = _Inner::value + 1;
+};
+
+// STRUCT TEMPLATE church_numeral_of
+template <class _ExprTy>
+struct church_numeral_of { // recognizes [lambda f. [lambda x. (f ... (f x))]]; one is eta reduced
+                           // to [lambda f. f] and stays an ordinary function
+    static constexpr bool matches = false;
+};
+
+template <class _FTy, class _XTy, class _Body>
+struct church_numeral_of<lambda_node<_FTy, lambda_node<_XTy, _Body>>> {
+    using _Count = std::conditional_t<std::is_same_v<typename _FTy::self, typename _XTy::self>
+        , _Church_body_count<void>
+        , _Church_count<typename _FTy::self, typename _XTy::self, typename _Body::self>>;
+    static constexpr bool matches = _Count::matches;
+    static constexpr size_t value = _Count::value;
+};
+
+// STRUCT TEMPLATE church_bool_of
+template <class _ExprTy>
+struct church_bool_of { // recognizes [lambda a. [lambda b. a]]; false is the numeral zero
+    static constexpr bool matches = false;
+};
+
+template <class _ATy, class _BTy>
+struct church_bool_of<lambda_node<_ATy, lambda_node<_BTy, _ATy>>> {
+    static constexpr bool matches = !std::is_same_v<typename _ATy::self, typename _BTy::self>;
+    static constexpr bool value = true;
+};
+
+template <class _ExprTy, class _Scope, class = void>
+struct _Lower { // variable, _Scope lists the binders innermost first
+    static_assert(is_variable_v<_ExprTy>, "invalid _ExprTy");
+    static_assert(_Scope::template contains<typename _ExprTy::self>, "lower requires a closed term");
+
+    template <class _EnvTy>
+    static constexpr decltype(auto) apply(const _EnvTy& _Env) noexcept
+    {
+        return std::get<_Scope::template index_of<typename _ExprTy::self>>(_Env);
+    }
+};
+
+template <class _ExprTy, class _Scope>
+struct _Lower<_ExprTy, _Scope, std::enable_if_t<church_numeral_of<_ExprTy>::matches>> {
+    template <class _EnvTy>
+    static constexpr church_constant<church_numeral_of<_ExprTy>::value> apply(const _EnvTy&) noexcept
+    {
+        return {};
+    }
+};
+
+template <class _ExprTy, class _Scope>
+struct _Lower<_ExprTy, _Scope, std::enable_if_t<church_bool_of<_ExprTy>::matches>> {
+    template <class _EnvTy>
+    static constexpr church_bool<true> apply(const _EnvTy&) noexcept
+    {
+        return {};
+    }
+};
+
+template <class _VarTy, class _ExprTy, class _Scope>
+struct _Lower<lambda_node<_VarTy, _ExprTy>, _Scope, std::enable_if_t<
+    !church_numeral_of<lambda_node<_VarTy, _ExprTy>>::matches
+    && !church_bool_of<lambda_node<_VarTy, _ExprTy>>::matches>>
+{ // lambda(x, a) -> [env](auto x) { return a; }
+    using _Body = _Lower<typename _ExprTy::self
+        , std_ext::type_forward_after_t<_Scope, std_ext::type_list, typename _VarTy::self>>;
+
+    template <class _EnvTy>
+    static constexpr auto apply(const _EnvTy& _Env) noexcept
+    {
+        return [_Env](auto _Arg) constexpr {
+            return _Body::apply(std::tuple_cat(std::make_tuple(std::move(_Arg)), _Env));
+        };
+    }
+};
+
+template <class _FuncTy, class _ArgTy, class _Scope>
+struct _Lower<application_node<_FuncTy, _ArgTy>, _Scope> { // f(a) -> f(a)
+    template <class _EnvTy>
+    static constexpr auto apply(const _EnvTy& _Env)
+    {
+        return _Lower<typename _FuncTy::self, _Scope>::apply(_Env)(
+            _Lower<typename _ArgTy::self, _Scope>::apply(_Env));
+    }
+};
+
+// FUNCTION TEMPLATE lower
+template <class _ExprTy, std::enable_if_t<is_nightly_lambda_v<_ExprTy>, int> = 0>
+constexpr auto lower(const _ExprTy&) noexcept
+{ // the normal form of a closed term as a native function object
+    return _Lower<full_reduction_t<_ExprTy>, std_ext::type_list<>>::apply(std::tuple<>{});
+}
+
+} // namespace nightly_lambda
+
+#endif // header guard
@@ -0,0 +1,504 @@
+// NightlyNbe.h - implements normalization by evaluation for runtime terms,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// `normalize` in NightlyRuntime.h rewrites terms: every beta step copies the spine of the body
+// down to each occurrence of the parameter. Normalization by evaluation never does that. The
+// term is compiled once into de Bruijn form, evaluated into closures and neutral values whose
+// environments are shared lists of lazily forced thunks, and finally read back into named
+// nodes of the `term_arena`. Read-back counts binders by de Bruijn level, so a fresh variable
+// is just the next level and no renaming is needed on the way down. All values live in a bump
+// arena that `nbe_engine` rewinds between terms.
+
+#pragma once
+#ifndef YUAN_NIGHTLY_NBE
+#define YUAN_NIGHTLY_NBE
+
+#include "NightlyRuntime.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace nightly_lambda {
+namespace runtime {
+
+// CLASS _Bump_arena
+class _Bump_arena { // hands out memory for trivially destructible objects, freed all at once
+public:
+    _Bump_arena() = default;
+    _Bump_arena(const _Bump_arena&) = delete;
+    _Bump_arena& operator=(const _Bump_arena&) = delete;
+
+    template <class _Ty, class... _Args>
+    _Ty* make(_Args&&... _Vals)
+    {
+        static_assert(std::is_trivially_destructible_v<_Ty>, "arena objects are never destroyed");
+        void* _Mem = _Allocate(sizeof(_Ty), alignof(_Ty));
+        return ::new (_Mem) _Ty{std::forward<_Args>(_Vals)...};
+    }
+
+    void rewind() noexcept
+    { // keeps the blocks for the next term
+        _Block = 0;
+        _Used = 0;
+    }
+
+    size_t reserved_bytes() const noexcept
+    {
+        return _Blocks.size() * _Block_size;
+    }
+
+private:
+    static constexpr size_t _Block_size = size_t{1} << 16;
+
+    void* _Allocate(size_t _Size, size_t _Align)
+    {
+        for (;;) {
+            if (_Block < _Blocks.size()) {
+                const size_t _Offset = (_Used + _Align - 1) & ~(_Align - 1);
+                if (_Offset + _Size <= _Block_size) {
+                    _Used = _Offset + _Size;
+                    return _Blocks[_Block].get() + _Offset;
+                }
+
+                ++_Block;
+                _Used = 0;
+                continue;
+            }
+
+            _Blocks.emplace_back(new std::byte[_Block_size]);
+        }
+    }
+
+    std::vector<std::unique_ptr<std::byte[]>> _Blocks;
+    size_t _Block = 0;
+    size_t _Used = 0;
+};
+
+// ENUM CLASS _Nbe_code_kind
+enum class _Nbe_code_kind : unsigned char { bound, free, lambda, application };
+
+// STRUCT _Nbe_code
+struct _Nbe_code { // a node of the de Bruijn form, children are indices into the same vector
+    _Nbe_code_kind kind;
+    std::uint32_t first;  // bound: de Bruijn index; free: name; lambda: parameter; application: function
+    std::uint32_t second; // lambda: body; application: argument
+};
+
+// FUNCTION _Compile_nbe_code
+inline std::uint32_t _Compile_nbe_code(const term_arena& _Arena, term_ref _Term
+    , std::vector<std::uint32_t>& _Innermost, std::vector<_Nbe_code>& _Code)
+{ // named -> de Bruijn, children before parents; `_Innermost[x]` is one plus the depth of
+  // the binder of x in scope
+    struct _Frame {
+        term_ref _Term;
+        std::uint32_t _Depth;
+        std::uint32_t _Saved; // lambda: `_Innermost` of the parameter outside
+        bool _Entered;
+    };
+    std::vector<_Frame> _Stack{{_Term, 0, 0, false}};
+    std::vector<std::uint32_t> _Compiled; // codes of finished children
+    const auto _Push_code = [&](_Nbe_code_kind _Kind, std::uint32_t _First, std::uint32_t _Second) {
+        _Code.push_back({_Kind, _First, _Second});
+        _Compiled.push_back(static_cast<std::uint32_t>(_Code.size() - 1));
+    };
+
+    while (!_Stack.empty()) {
+        const _Frame _Top = _Stack.back(); // copied, pushing may move the frames
+        const term_node& _Node = _Arena[_Top._Term];
+        if (_Node.kind == term_kind::variable) {
+            _Stack.pop_back();
+            if (_Innermost[_Node.first] == 0) {
+                _Push_code(_Nbe_code_kind::free, _Node.first, 0);
+            } else {
+                _Push_code(_Nbe_code_kind::bound, _Top._Depth - _Innermost[_Node.first], 0);
+            }
+        } else if (!_Top._Entered) {
+            _Stack.back()._Entered = true;
+            if (_Node.kind == term_kind::lambda) {
+                _Stack.back()._Saved = _Innermost[_Node.first];
+                _Innermost[_Node.first] = _Top._Depth + 1;
+                _Stack.push_back({_Node.second, _Top._Depth + 1, 0, false});
+            } else {
+                _Stack.push_back({_Node.second, _Top._Depth, 0, false});
+                _Stack.push_back({_Node.first, _Top._Depth, 0, false});
+            }
+        } else if (_Node.kind == term_kind::lambda) {
+            _Stack.pop_back();
+            _Innermost[_Node.first] = _Top._Saved;
+            const std::uint32_t _Body = _Compiled.back();
+            _Compiled.pop_back();
+            _Push_code(_Nbe_code_kind::lambda, _Node.first, _Body);
+        } else {
+            _Stack.pop_back();
+            const std::uint32_t _Arg = _Compiled.back();
+            _Compiled.pop_back();
+            const std::uint32_t _Func = _Compiled.back();
+            _Compiled.pop_back();
+            _Push_code(_Nbe_code_kind::application, _Func, _Arg);
+        }
+    }
+
+    return _Compiled.back();
+}
+
+struct _Nbe_value;
+struct _Nbe_env;
+
+// STRUCT _Nbe_thunk
+struct _Nbe_thunk { // an argument, evaluated the first time it is needed
+    std::uint32_t code;
+    const _Nbe_env* env;
+    const _Nbe_value* value;
+};
+
+// STRUCT _Nbe_env
+struct _Nbe_env {
+    _Nbe_thunk* head; // de Bruijn index 0
+    const _Nbe_env* tail;
+};
+
+// STRUCT _Nbe_spine
+struct _Nbe_spine { // arguments of a neutral value, the last one first
+    _Nbe_thunk* arg;
+    const _Nbe_spine* prev;
+};
+
+// STRUCT _Nbe_value
+struct _Nbe_value {
+    bool is_closure;
+    bool free_head;       // neutral: head is a free name rather than a level
+    std::uint32_t first;  // closure: code of the lambda; neutral: level or name of the head
+    const _Nbe_env* env;  // closure only
+    const _Nbe_spine* spine; // neutral only
+};
+
+// CLASS nbe_engine
+class nbe_engine { // reusable, one per thread
+public:
+    nbe_engine() = default;
+    nbe_engine(const nbe_engine&) = delete;
+    nbe_engine& operator=(const nbe_engine&) = delete;
+
+    term_ref normalize(term_arena& _Arena_, term_ref _Term
+        , const reduction_options& _Options, reduction_stats& _Stats_)
+    { // the strategy is ignored, `steps` counts closure applications and eta steps,
+      // `peak_size` is the larger of the input and the normal form; out of fuel, it returns
+      // _Term unreduced, since a machine stopped half-way holds no term, where `normalize`
+      // returns the reduct so far
+        _Arena = &_Arena_;
+        _Stats = &_Stats_;
+        _Fuel = _Options.fuel;
+        _Values.rewind();
+        _Code.clear();
+        _Clear_names();
+        _Frames.clear();
+        _Pending.clear();
+        _In_scope.resize(_Arena->symbol_count(), 0);
+        _Innermost.resize(_Arena->symbol_count(), 0);
+
+        _Note_size(_Term);
+        _Free = free_variables(*_Arena, _Term);
+        for (const symbol _Name : _Free) {
+            _In_scope[_Name] = 1; // never reuse a free name for a binder
+        }
+
+        _Compiling = true;
+        const std::uint32_t _Root = _Compile_nbe_code(*_Arena, _Term, _Innermost, _Code);
+        _Compiling = false;
+        term_ref _Result;
+        try {
+            _Result = _Run(_Root);
+        } catch (const _Out_of_fuel&) {
+            _Stats->exhausted = true;
+            return _Term;
+        }
+
+        _Note_size(_Result);
+        return _Result;
+    }
+
+    term_ref normalize(term_arena& _Arena_, term_ref _Term)
+    {
+        reduction_stats _Stats_;
+        return normalize(_Arena_, _Term, reduction_options{}, _Stats_);
+    }
+
+    size_t arena_bytes() const noexcept
+    {
+        return _Values.reserved_bytes();
+    }
+
+private:
+    struct _Out_of_fuel {};
+
+    void _Note_size(term_ref _Term) noexcept
+    {
+        if ((*_Arena)[_Term].size > _Stats->peak_size) {
+            _Stats->peak_size = (*_Arena)[_Term].size;
+        }
+    }
+
+    void _Take_step()
+    {
+        if (_Stats->steps >= _Fuel) {
+            throw _Out_of_fuel{};
+        }
+
+        ++_Stats->steps;
+    }
+
+    // Evaluation and read-back run as one machine on explicit stacks, so neither the depth
+    // of the term nor that of its normal form is bounded by the thread's stack.
+
+    enum class _Frame_kind : unsigned char {
+        _Arg,    // thunk: an argument waiting for its function
+        _Update, // thunk: being forced
+        _Read,   // a: level, the returned value is read back
+        _Close,  // a: name, the term delivered is the body of a lambda
+        _Apply   // a: term so far, b: arguments left on `_Pending`, c: level
+    };
+
+    struct _Frame {
+        _Frame_kind kind;
+        std::uint32_t a;
+        std::uint32_t b;
+        std::uint32_t c;
+        _Nbe_thunk* thunk;
+    };
+
+    static _Nbe_thunk* _Lookup(const _Nbe_env* _Env, std::uint32_t _Index) noexcept
+    {
+        for (; _Index != 0; --_Index) {
+            _Env = _Env->tail;
+        }
+
+        return _Env->head;
+    }
+
+    void _Clear_names() noexcept
+    { // the tables by name stay zero between calls, so that a call costs what its own names
+      // cost and not every name the arena has seen; this undoes what the last call left
+        for (const symbol _Name : _Names) {
+            _In_scope[_Name] = 0;
+        }
+
+        for (const symbol _Name : _Free) {
+            _In_scope[_Name] = 0;
+        }
+
+        if (_Compiling) { // it threw half-way, with binders still set
+            std::fill(_Innermost.begin(), _Innermost.end(), 0);
+            _Compiling = false;
+        }
+
+        _Names.clear();
+        _Free.clear();
+    }
+
+    symbol _Bind_name(symbol _Param)
+    { // a name that no enclosing binder and no free variable uses
+        while (_Param < _In_scope.size() && _In_scope[_Param] != 0) {
+            _Param = _Arena->primed(_Param);
+        }
+
+        if (_Param >= _In_scope.size()) {
+            _In_scope.resize(_Arena->symbol_count(), 0);
+        }
+
+        ++_In_scope[_Param];
+        _Names.push_back(_Param);
+        return _Param;
+    }
+
+    term_ref _Close(symbol _Name, term_ref _Body)
+    { // lambda(x, f(x)) -> f, x is unique in scope so `occurs_free` is exact
+        const term_node& _Node = (*_Arena)[_Body];
+        if (_Node.kind == term_kind::application
+            && (*_Arena)[_Node.second].kind == term_kind::variable
+            && (*_Arena)[_Node.second].first == _Name
+            && !occurs_free(*_Arena, _Node.first, _Name)) {
+            if (_Stats->steps < _Fuel) {
+                ++_Stats->steps;
+                return _Node.first;
+            }
+
+            _Stats->exhausted = true; // what is read back is not eta-normal
+        }
+
+        return _Arena->lambda(_Name, _Body);
+    }
+
+    term_ref _Run(std::uint32_t _Code_idx)
+    { // evaluates `_Code_idx` in `_Env`, returns `_Value` to the frame on top, or delivers
+      // the read-back `_Delivered` to it
+        enum class _Mode { _Eval, _Return, _Deliver };
+        const _Nbe_env* _Env = nullptr;
+        const _Nbe_value* _Value = nullptr;
+        term_ref _Delivered = 0;
+        _Mode _State = _Mode::_Eval;
+        const auto _Force = [&](_Nbe_thunk* _Thunk) {
+            if (_Thunk->value) {
+                _Value = _Thunk->value;
+                _State = _Mode::_Return;
+            } else {
+                _Frames.push_back({_Frame_kind::_Update, 0, 0, 0, _Thunk});
+                _Code_idx = _Thunk->code;
+                _Env = _Thunk->env;
+                _State = _Mode::_Eval;
+            }
+        };
+
+        const auto _Next_argument = [&] { // continues the `_Apply` frame on top
+            _Frame& _Top = _Frames.back();
+            if (_Top.b == 0) {
+                _Delivered = _Top.a;
+                _Frames.pop_back();
+                _State = _Mode::_Deliver;
+                return;
+            }
+
+            --_Top.b;
+            const std::uint32_t _Level = _Top.c;
+            _Nbe_thunk* const _Thunk = _Pending.back();
+            _Pending.pop_back();
+            _Frames.push_back({_Frame_kind::_Read, _Level, 0, 0, nullptr});
+            _Force(_Thunk);
+        };
+
+        _Frames.push_back({_Frame_kind::_Read, 0, 0, 0, nullptr});
+        for (;;) {
+            switch (_State) {
+            case _Mode::_Eval:
+            {
+                const _Nbe_code _Node = _Code[_Code_idx];
+                switch (_Node.kind) {
+                case _Nbe_code_kind::bound:
+                    _Force(_Lookup(_Env, _Node.first));
+                    break;
+                case _Nbe_code_kind::free:
+                    _Value = _Values.make<_Nbe_value>(false, true, _Node.first, nullptr, nullptr);
+                    _State = _Mode::_Return;
+                    break;
+                case _Nbe_code_kind::lambda:
+                    if (_Frames.back().kind == _Frame_kind::_Arg) { // continue with the body
+                        _Take_step();
+                        _Env = _Values.make<_Nbe_env>(_Frames.back().thunk, _Env);
+                        _Frames.pop_back();
+                        _Code_idx = _Node.second;
+                    } else {
+                        _Value = _Values.make<_Nbe_value>(true, false, _Code_idx, _Env, nullptr);
+                        _State = _Mode::_Return;
+                    }
+                    break;
+                default:
+                {
+                    const _Nbe_code& _Arg = _Code[_Node.second];
+                    _Nbe_thunk* const _Thunk = _Arg.kind == _Nbe_code_kind::bound
+                        ? _Lookup(_Env, _Arg.first) // share the thunk instead of wrapping it
+                        : _Values.make<_Nbe_thunk>(_Node.second, _Env, nullptr);
+                    _Frames.push_back({_Frame_kind::_Arg, 0, 0, 0, _Thunk});
+                    _Code_idx = _Node.first;
+                    break;
+                }
+                }
+
+                break;
+            }
+            case _Mode::_Return:
+            {
+                const _Frame _Top = _Frames.back();
+                _Frames.pop_back();
+                if (_Top.kind == _Frame_kind::_Update) {
+                    _Top.thunk->value = _Value;
+                    _Top.thunk->env = nullptr; // let the environment go
+                } else if (_Top.kind == _Frame_kind::_Arg) {
+                    if (_Value->is_closure) {
+                        _Take_step();
+                        _Env = _Values.make<_Nbe_env>(_Top.thunk, _Value->env);
+                        _Code_idx = _Code[_Value->first].second;
+                        _State = _Mode::_Eval;
+                    } else {
+                        _Value = _Values.make<_Nbe_value>(false, _Value->free_head, _Value->first, nullptr
+                            , _Values.make<_Nbe_spine>(_Top.thunk, _Value->spine));
+                    }
+                } else if (_Value->is_closure) { // _Read, go under the binder
+                    const _Nbe_code& _Lambda = _Code[_Value->first];
+                    _Frames.push_back({_Frame_kind::_Close, _Bind_name(_Lambda.first), 0, 0, nullptr});
+                    _Frames.push_back({_Frame_kind::_Read, _Top.a + 1, 0, 0, nullptr});
+                    const _Nbe_value* _Fresh = _Values.make<_Nbe_value>(false, false, _Top.a, nullptr, nullptr);
+                    _Nbe_thunk* _Var = _Values.make<_Nbe_thunk>(0u, nullptr, _Fresh);
+                    _Env = _Values.make<_Nbe_env>(_Var, _Value->env);
+                    _Code_idx = _Lambda.second;
+                    _State = _Mode::_Eval;
+                } else { // _Read, the head applied to the spine
+                    std::uint32_t _Count = 0;
+                    for (const _Nbe_spine* _Spine = _Value->spine; _Spine; _Spine = _Spine->prev) {
+                        _Pending.push_back(_Spine->arg); // the last argument first, the first on top
+                        ++_Count;
+                    }
+
+                    const term_ref _Head =
+                        _Arena->variable(_Value->free_head ? _Value->first : _Names[_Value->first]);
+                    _Frames.push_back({_Frame_kind::_Apply, _Head, _Count, _Top.a, nullptr});
+                    _Next_argument();
+                }
+
+                break;
+            }
+            default: // _Deliver
+                if (_Frames.empty()) {
+                    return _Delivered;
+                }
+
+                if (_Frames.back().kind == _Frame_kind::_Close) {
+                    const symbol _Name = _Frames.back().a;
+                    _Frames.pop_back();
+                    --_In_scope[_Name];
+                    _Names.pop_back();
+                    _Delivered = _Close(_Name, _Delivered);
+                } else { // _Apply
+                    _Frames.back().a = _Arena->application(_Frames.back().a, _Delivered);
+                    _Next_argument();
+                }
+
+                break;
+            }
+        }
+    }
+
+    term_arena* _Arena = nullptr;
+    reduction_stats* _Stats = nullptr;
+    std::uint64_t _Fuel = 0;
+    _Bump_arena _Values;
+    std::vector<_Nbe_code> _Code;
+    std::vector<symbol> _Names;          // binder name by de Bruijn level
+    std::vector<std::uint32_t> _In_scope; // by name, binders using it plus one if free
+    std::vector<std::uint32_t> _Innermost;
+    std::vector<symbol> _Free; // of the term, marked in `_In_scope`
+    bool _Compiling = false;
+    std::vector<_Frame> _Frames;
+    std::vector<_Nbe_thunk*> _Pending; // arguments of neutral values still to be read back
+};
+
+// FUNCTION nbe_normalize
+inline term_ref nbe_normalize(term_arena& _Arena, term_ref _Term
+    , const reduction_options& _Options, reduction_stats& _Stats)
+{
+    nbe_engine _Engine;
+    return _Engine.normalize(_Arena, _Term, _Options, _Stats);
+}
+
+inline term_ref nbe_normalize(term_arena& _Arena, term_ref _Term)
+{
+    nbe_engine _Engine;
+    return _Engine.normalize(_Arena, _Term);
+}
+
+} // namespace runtime
+} // namespace nightly_lambda
+
+#endif // header guard
@@ -0,0 +1,24 @@
+// NightlyPrelude.cppm - implements the prelude as a C++20 module,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// Generated by tools/gen_prelude.cpp --numerals=16, do not edit.
+//
+// `import nightly_lambda.prelude;` provides the library and the prelude. The interface is
+// compiled once per build, and importers read the terms from its binary module interface
+// instead of parsing and instantiating NightlyLambda.h again. The standard headers the
+// library includes go to the global module fragment, so that they stay out of the module.
+
+module;
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <tuple>
+#include <type_traits>
+
+export module nightly_lambda.prelude;
+
+export {
+#include "NightlyPrelude.h"
+}
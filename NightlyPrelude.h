@@ -0,0 +1,354 @@
+// NightlyPrelude.h - implements pre-normalized standard terms,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// Generated by tools/gen_prelude.cpp --numerals=16, do not edit.
+//
+// Every term is spelled as the type of its normal form, so naming one costs no reduction.
+// `numeral_t<N>` is church_N for N up to `numeral_limit`. Define NIGHTLY_PRELUDE_VERIFY to
+// check the spellings against the library; that instantiates everything this header saves.
+
+#pragma once
+#ifndef YUAN_NIGHTLY_PRELUDE
+#define YUAN_NIGHTLY_PRELUDE
+
+#include "NightlyLambda.h"
+
+namespace nightly_lambda {
+namespace prelude {
+
+// [lambda x. x]
+using i_combinator_t = lambda_node<variable_node<23>, variable_node<23>>;
+inline constexpr _Public_term_t<i_combinator_t> i_combinator{};
+
+// [lambda x. [lambda y. x]]
+using k_combinator_t = lambda_node<variable_node<23>, lambda_node<variable_node<24>, variable_node<23>>>;
+inline constexpr _Public_term_t<k_combinator_t> k_combinator{};
+
+// [lambda x. [lambda y. [lambda z. ((x z) (y z))]]]
+using s_combinator_t = lambda_node<variable_node<23>, lambda_node<variable_node<24>, lambda_node<variable_node<25>, application_node<application_node<variable_node<23>, variable_node<25>>, application_node<variable_node<24>, variable_node<25>>>>>>;
+inline constexpr _Public_term_t<s_combinator_t> s_combinator{};
+
+// [lambda f. [lambda g. [lambda x. (f (g x))]]]
+using b_combinator_t = lambda_node<variable_node<5>, lambda_node<variable_node<6>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<6>, variable_node<23>>>>>>;
+inline constexpr _Public_term_t<b_combinator_t> b_combinator{};
+
+// [lambda f. [lambda x. [lambda y. ((f y) x)]]]
+using c_combinator_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, lambda_node<variable_node<24>, application_node<application_node<variable_node<5>, variable_node<24>>, variable_node<23>>>>>;
+inline constexpr _Public_term_t<c_combinator_t> c_combinator{};
+
+// [lambda f. [lambda x. ((f x) x)]]
+using w_combinator_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<application_node<variable_node<5>, variable_node<23>>, variable_node<23>>>>;
+inline constexpr _Public_term_t<w_combinator_t> w_combinator{};
+
+// [lambda x. (x x)]
+using omega_t = lambda_node<variable_node<23>, application_node<variable_node<23>, variable_node<23>>>;
+inline constexpr _Public_term_t<omega_t> omega{};
+
+// [lambda a. [lambda b. a]]
+using church_true_t = lambda_node<variable_node<0>, lambda_node<variable_node<1>, variable_node<0>>>;
+inline constexpr _Public_term_t<church_true_t> church_true{};
+
+// [lambda a. [lambda b. b]]
+using church_false_t = lambda_node<variable_node<0>, lambda_node<variable_node<1>, variable_node<1>>>;
+inline constexpr _Public_term_t<church_false_t> church_false{};
+
+// [lambda p. [lambda a. [lambda b. ((p b) a)]]]
+using church_not_t = lambda_node<variable_node<15>, lambda_node<variable_node<0>, lambda_node<variable_node<1>, application_node<application_node<variable_node<15>, variable_node<1>>, variable_node<0>>>>>;
+inline constexpr _Public_term_t<church_not_t> church_not{};
+
+// [lambda p. [lambda q. ((p q) p)]]
+using church_and_t = lambda_node<variable_node<15>, lambda_node<variable_node<16>, application_node<application_node<variable_node<15>, variable_node<16>>, variable_node<15>>>>;
+inline constexpr _Public_term_t<church_and_t> church_and{};
+
+// [lambda p. (p p)]
+using church_or_t = lambda_node<variable_node<15>, application_node<variable_node<15>, variable_node<15>>>;
+inline constexpr _Public_term_t<church_or_t> church_or{};
+
+// [lambda n. [lambda f. [lambda x. (f ((n f) x))]]]
+using church_succ_t = lambda_node<variable_node<13>, lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<application_node<variable_node<13>, variable_node<5>>, variable_node<23>>>>>>;
+inline constexpr _Public_term_t<church_succ_t> church_succ{};
+
+// [lambda n. [lambda f. [lambda x. (((n [lambda g. [lambda h. (h (g f))]]) [lambda u. x]) [lambda u. u])]]]
+using church_pred_t = lambda_node<variable_node<13>, lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<application_node<application_node<variable_node<13>, lambda_node<variable_node<6>, lambda_node<variable_node<7>, application_node<variable_node<7>, application_node<variable_node<6>, variable_node<5>>>>>>, lambda_node<variable_node<20>, variable_node<23>>>, lambda_node<variable_node<20>, variable_node<20>>>>>>;
+inline constexpr _Public_term_t<church_pred_t> church_pred{};
+
+// [lambda m. [lambda n. [lambda f. [lambda x. ((m f) ((n f) x))]]]]
+using church_add_t = lambda_node<variable_node<12>, lambda_node<variable_node<13>, lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<application_node<variable_node<12>, variable_node<5>>, application_node<application_node<variable_node<13>, variable_node<5>>, variable_node<23>>>>>>>;
+inline constexpr _Public_term_t<church_add_t> church_add{};
+
+// [lambda m. [lambda n. [lambda f. (m (n f))]]]
+using church_mul_t = lambda_node<variable_node<12>, lambda_node<variable_node<13>, lambda_node<variable_node<5>, application_node<variable_node<12>, application_node<variable_node<13>, variable_node<5>>>>>>;
+inline constexpr _Public_term_t<church_mul_t> church_mul{};
+
+// [lambda m. [lambda n. (n m)]]
+using church_exp_t = lambda_node<variable_node<12>, lambda_node<variable_node<13>, application_node<variable_node<13>, variable_node<12>>>>;
+inline constexpr _Public_term_t<church_exp_t> church_exp{};
+
+// [lambda n. ((n [lambda x. [lambda a. [lambda b. b]]]) [lambda a. [lambda b. a]])]
+using church_iszero_t = lambda_node<variable_node<13>, application_node<application_node<variable_node<13>, lambda_node<variable_node<23>, lambda_node<variable_node<0>, lambda_node<variable_node<1>, variable_node<1>>>>>, lambda_node<variable_node<0>, lambda_node<variable_node<1>, variable_node<0>>>>>;
+inline constexpr _Public_term_t<church_iszero_t> church_iszero{};
+
+// [lambda a. [lambda b. [lambda f. ((f a) b)]]]
+using church_pair_t = lambda_node<variable_node<0>, lambda_node<variable_node<1>, lambda_node<variable_node<5>, application_node<application_node<variable_node<5>, variable_node<0>>, variable_node<1>>>>>;
+inline constexpr _Public_term_t<church_pair_t> church_pair{};
+
+// [lambda p. (p [lambda a. [lambda b. a]])]
+using church_first_t = lambda_node<variable_node<15>, application_node<variable_node<15>, lambda_node<variable_node<0>, lambda_node<variable_node<1>, variable_node<0>>>>>;
+inline constexpr _Public_term_t<church_first_t> church_first{};
+
+// [lambda p. (p [lambda a. [lambda b. b]])]
+using church_second_t = lambda_node<variable_node<15>, application_node<variable_node<15>, lambda_node<variable_node<0>, lambda_node<variable_node<1>, variable_node<1>>>>>;
+inline constexpr _Public_term_t<church_second_t> church_second{};
+
+// [lambda f. [lambda x. x]]
+using church_0_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, variable_node<23>>>;
+inline constexpr _Public_term_t<church_0_t> church_0{};
+
+// [lambda f. f]
+using church_1_t = lambda_node<variable_node<5>, variable_node<5>>;
+inline constexpr _Public_term_t<church_1_t> church_1{};
+
+// [lambda f. [lambda x. (f (f x))]]
+using church_2_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>;
+inline constexpr _Public_term_t<church_2_t> church_2{};
+
+// [lambda f. [lambda x. (f (f (f x)))]]
+using church_3_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>;
+inline constexpr _Public_term_t<church_3_t> church_3{};
+
+// [lambda f. [lambda x. (f (f (f (f x))))]]
+using church_4_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>;
+inline constexpr _Public_term_t<church_4_t> church_4{};
+
+// [lambda f. [lambda x. (f (f (f (f (f x)))))]]
+using church_5_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>;
+inline constexpr _Public_term_t<church_5_t> church_5{};
+
+// [lambda f. [lambda x. (f (f (f (f (f (f x))))))]]
+using church_6_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>>;
+inline constexpr _Public_term_t<church_6_t> church_6{};
+
+// [lambda f. [lambda x. (f (f (f (f (f (f (f x)))))))]]
+using church_7_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>>>;
+inline constexpr _Public_term_t<church_7_t> church_7{};
+
+// [lambda f. [lambda x. (f (f (f (f (f (f (f (f x))))))))]]
+using church_8_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>>>>;
+inline constexpr _Public_term_t<church_8_t> church_8{};
+
+// [lambda f. [lambda x. (f (f (f (f (f (f (f (f (f x)))))))))]]
+using church_9_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>>>>>;
+inline constexpr _Public_term_t<church_9_t> church_9{};
+
+// [lambda f. [lambda x. (f (f (f (f (f (f (f (f (f (f x))))))))))]]
+using church_10_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>>>>>>;
+inline constexpr _Public_term_t<church_10_t> church_10{};
+
+// [lambda f. [lambda x. (f (f (f (f (f (f (f (f (f (f (f x)))))))))))]]
+using church_11_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>>>>>>>;
+inline constexpr _Public_term_t<church_11_t> church_11{};
+
+// [lambda f. [lambda x. (f (f (f (f (f (f (f (f (f (f (f (f x))))))))))))]]
+using church_12_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>>>>>>>>;
+inline constexpr _Public_term_t<church_12_t> church_12{};
+
+// [lambda f. [lambda x. (f (f (f (f (f (f (f (f (f (f (f (f (f x)))))))))))))]]
+using church_13_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>>>>>>>>>;
+inline constexpr _Public_term_t<church_13_t> church_13{};
+
+// [lambda f. [lambda x. (f (f (f (f (f (f (f (f (f (f (f (f (f (f x))))))))))))))]]
+using church_14_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>>>>>>>>>>;
+inline constexpr _Public_term_t<church_14_t> church_14{};
+
+// [lambda f. [lambda x. (f (f (f (f (f (f (f (f (f (f (f (f (f (f (f x)))))))))))))))]]
+using church_15_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>>>>>>>>>>>;
+inline constexpr _Public_term_t<church_15_t> church_15{};
+
+// [lambda f. [lambda x. (f (f (f (f (f (f (f (f (f (f (f (f (f (f (f (f x))))))))))))))))]]
+using church_16_t = lambda_node<variable_node<5>, lambda_node<variable_node<23>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, application_node<variable_node<5>, variable_node<23>>>>>>>>>>>>>>>>>>>;
+inline constexpr _Public_term_t<church_16_t> church_16{};
+
+inline constexpr size_t numeral_limit = 16;
+
+template <size_t _Nx>
+struct _Numeral {
+    static_assert(_Nx <= numeral_limit, "regenerate the prelude with a larger --numerals");
+};
+
+template <>
+struct _Numeral<0> {
+    using type = church_0_t;
+};
+
+template <>
+struct _Numeral<1> {
+    using type = church_1_t;
+};
+
+template <>
+struct _Numeral<2> {
+    using type = church_2_t;
+};
+
+template <>
+struct _Numeral<3> {
+    using type = church_3_t;
+};
+
+template <>
+struct _Numeral<4> {
+    using type = church_4_t;
+};
+
+template <>
+struct _Numeral<5> {
+    using type = church_5_t;
+};
+
+template <>
+struct _Numeral<6> {
+    using type = church_6_t;
+};
+
+template <>
+struct _Numeral<7> {
+    using type = church_7_t;
+};
+
+template <>
+struct _Numeral<8> {
+    using type = church_8_t;
+};
+
+template <>
+struct _Numeral<9> {
+    using type = church_9_t;
+};
+
+template <>
+struct _Numeral<10> {
+    using type = church_10_t;
+};
+
+template <>
+struct _Numeral<11> {
+    using type = church_11_t;
+};
+
+template <>
+struct _Numeral<12> {
+    using type = church_12_t;
+};
+
+template <>
+struct _Numeral<13> {
+    using type = church_13_t;
+};
+
+template <>
+struct _Numeral<14> {
+    using type = church_14_t;
+};
+
+template <>
+struct _Numeral<15> {
+    using type = church_15_t;
+};
+
+template <>
+struct _Numeral<16> {
+    using type = church_16_t;
+};
+
+// ALIAS TEMPLATE numeral_t
+template <size_t _Nx>
+using numeral_t = typename _Numeral<_Nx>::type;
+
+#ifdef NIGHTLY_PRELUDE_VERIFY
+namespace _Verify {
+using namespace names;
+
+static_assert(std::is_same_v<i_combinator_t
+    , typename decltype(evaluate(lambda(x, x)))::self>, "i_combinator");
+static_assert(std::is_same_v<k_combinator_t
+    , typename decltype(evaluate(lambda(x, y, x)))::self>, "k_combinator");
+static_assert(std::is_same_v<s_combinator_t
+    , typename decltype(evaluate(lambda(x, y, z, x(z)(y(z)))))::self>, "s_combinator");
+static_assert(std::is_same_v<b_combinator_t
+    , typename decltype(evaluate(lambda(f, g, x, f(g(x)))))::self>, "b_combinator");
+static_assert(std::is_same_v<c_combinator_t
+    , typename decltype(evaluate(lambda(f, x, y, f(y)(x))))::self>, "c_combinator");
+static_assert(std::is_same_v<w_combinator_t
+    , typename decltype(evaluate(lambda(f, x, f(x)(x))))::self>, "w_combinator");
+static_assert(std::is_same_v<omega_t
+    , typename decltype(evaluate(lambda(x, x(x))))::self>, "omega");
+static_assert(std::is_same_v<church_true_t
+    , typename decltype(evaluate(lambda(a, b, a)))::self>, "church_true");
+static_assert(std::is_same_v<church_false_t
+    , typename decltype(evaluate(lambda(a, b, b)))::self>, "church_false");
+static_assert(std::is_same_v<church_not_t
+    , typename decltype(evaluate(lambda(p, a, b, p(b)(a))))::self>, "church_not");
+static_assert(std::is_same_v<church_and_t
+    , typename decltype(evaluate(lambda(p, q, p(q)(p))))::self>, "church_and");
+static_assert(std::is_same_v<church_or_t
+    , typename decltype(evaluate(lambda(p, q, p(p)(q))))::self>, "church_or");
+static_assert(std::is_same_v<church_succ_t
+    , typename decltype(evaluate(lambda(n, f, x, f(n(f)(x)))))::self>, "church_succ");
+static_assert(std::is_same_v<church_pred_t
+    , typename decltype(evaluate(lambda(n, f, x, n(lambda(g, h, h(g(f))))(lambda(u, x))(lambda(u, u)))))::self>, "church_pred");
+static_assert(std::is_same_v<church_add_t
+    , typename decltype(evaluate(lambda(m, n, f, x, m(f)(n(f)(x)))))::self>, "church_add");
+static_assert(std::is_same_v<church_mul_t
+    , typename decltype(evaluate(lambda(m, n, f, m(n(f)))))::self>, "church_mul");
+static_assert(std::is_same_v<church_exp_t
+    , typename decltype(evaluate(lambda(m, n, n(m))))::self>, "church_exp");
+static_assert(std::is_same_v<church_iszero_t
+    , typename decltype(evaluate(lambda(n, n(lambda(x, church_false))(church_true))))::self>, "church_iszero");
+static_assert(std::is_same_v<church_pair_t
+    , typename decltype(evaluate(lambda(a, b, f, f(a)(b))))::self>, "church_pair");
+static_assert(std::is_same_v<church_first_t
+    , typename decltype(evaluate(lambda(p, p(church_true))))::self>, "church_first");
+static_assert(std::is_same_v<church_second_t
+    , typename decltype(evaluate(lambda(p, p(church_false))))::self>, "church_second");
+static_assert(std::is_same_v<church_0_t
+    , typename decltype(evaluate(lambda(f, x, x)))::self>, "church_0");
+static_assert(std::is_same_v<church_1_t
+    , typename decltype(evaluate(lambda(f, x, f(x))))::self>, "church_1");
+static_assert(std::is_same_v<church_2_t
+    , typename decltype(evaluate(lambda(f, x, f(f(x)))))::self>, "church_2");
+static_assert(std::is_same_v<church_3_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(x))))))::self>, "church_3");
+static_assert(std::is_same_v<church_4_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(x)))))))::self>, "church_4");
+static_assert(std::is_same_v<church_5_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(x))))))))::self>, "church_5");
+static_assert(std::is_same_v<church_6_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(f(x)))))))))::self>, "church_6");
+static_assert(std::is_same_v<church_7_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(f(f(x))))))))))::self>, "church_7");
+static_assert(std::is_same_v<church_8_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(f(f(f(x)))))))))))::self>, "church_8");
+static_assert(std::is_same_v<church_9_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(f(f(f(f(x))))))))))))::self>, "church_9");
+static_assert(std::is_same_v<church_10_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(f(f(f(f(f(x)))))))))))))::self>, "church_10");
+static_assert(std::is_same_v<church_11_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(f(f(f(f(f(f(x))))))))))))))::self>, "church_11");
+static_assert(std::is_same_v<church_12_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(f(f(f(f(f(f(f(x)))))))))))))))::self>, "church_12");
+static_assert(std::is_same_v<church_13_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(f(f(f(f(f(f(f(f(x))))))))))))))))::self>, "church_13");
+static_assert(std::is_same_v<church_14_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(f(f(f(f(f(f(f(f(f(x)))))))))))))))))::self>, "church_14");
+static_assert(std::is_same_v<church_15_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(x))))))))))))))))))::self>, "church_15");
+static_assert(std::is_same_v<church_16_t
+    , typename decltype(evaluate(lambda(f, x, f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(f(x)))))))))))))))))))::self>, "church_16");
+} // namespace _Verify
+#endif // NIGHTLY_PRELUDE_VERIFY
+
+} // namespace prelude
+} // namespace nightly_lambda
+
+#endif // header guard
@@ -0,0 +1,1264 @@
+// NightlyRuntime.h - implements a runtime term representation and reducer,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// The compile-time library decides everything during instantiation, which is of no use
+// once the terms arrive as data. This header mirrors the library at runtime: terms live
+// in a `term_arena` as immutable nodes addressed by 32-bit `term_ref`s, subterms are
+// shared instead of copied, and `normalize` reduces them under one of three strategies.
+// The textual syntax is exactly the one produced by `operator<<` of the compile-time
+// nodes, so `to_runtime` can lift any compile-time term into the arena. Parsing, printing,
+// substitution and reduction keep their pending work on explicit stacks, so a term may be
+// nested as deeply as memory allows, not only as deeply as the thread's stack allows.
+
+#pragma once
+#ifndef YUAN_NIGHTLY_RUNTIME
+#define YUAN_NIGHTLY_RUNTIME
+
+#include "NightlyLambda.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace nightly_lambda {
+namespace runtime {
+
+using term_ref = std::uint32_t;
+using symbol = std::uint32_t;
+
+// ENUM CLASS term_kind
+enum class term_kind : unsigned char { variable, lambda, application };
+
+// STRUCT term_node
+struct term_node {
+    term_kind kind;
+    std::uint32_t first;  // variable: name; lambda: parameter; application: function
+    std::uint32_t second; // lambda: body; application: argument
+    std::uint64_t size;   // number of nodes of the unshared tree, saturating
+    std::uint64_t occurs; // bit (s % 64) is set for every variable s occurring below
+};
+
+inline constexpr std::uint64_t _Symbol_bit(symbol _Sym) noexcept
+{
+    return std::uint64_t{1} << (_Sym % 64);
+}
+
+inline constexpr std::uint64_t _Saturating_add(std::uint64_t _Left, std::uint64_t _Right) noexcept
+{
+    return _Left > std::numeric_limits<std::uint64_t>::max() - _Right
+        ? std::numeric_limits<std::uint64_t>::max() : _Left + _Right;
+}
+
+// CLASS term_arena
+class term_arena { // owns the nodes and the variable names of a group of terms
+public:
+    term_arena() = default;
+    term_arena(const term_arena&) = delete;
+    term_arena& operator=(const term_arena&) = delete;
+
+    symbol intern(std::string_view _Name)
+    {
+        std::string _Key(_Name);
+        const auto _Found = _Symbols.find(_Key);
+        if (_Found != _Symbols.end()) {
+            return _Found->second;
+        }
+
+        const auto _Sym = static_cast<symbol>(_Names.size());
+        _Names.push_back(_Key);
+        _Primed.push_back(_No_symbol);
+        _Symbols.emplace(std::move(_Key), _Sym);
+        return _Sym;
+    }
+
+    std::string_view name_of(symbol _Sym) const noexcept
+    {
+        return _Names[_Sym];
+    }
+
+    symbol primed(symbol _Sym)
+    { // x -> x', the same spelling `shadowed` uses
+        if (_Primed[_Sym] == _No_symbol) {
+            const symbol _New = intern(_Names[_Sym] + '\'');
+            _Primed[_Sym] = _New;
+        }
+
+        return _Primed[_Sym];
+    }
+
+    size_t symbol_count() const noexcept
+    {
+        return _Names.size();
+    }
+
+    term_ref variable(symbol _Sym)
+    {
+        return _Push({term_kind::variable, _Sym, 0, 1, _Symbol_bit(_Sym)});
+    }
+
+    term_ref lambda(symbol _Param, term_ref _Body)
+    {
+        const term_node& _Node = _Nodes[_Body];
+        return _Push({term_kind::lambda, _Param, _Body
+            , _Saturating_add(_Node.size, 1), _Node.occurs | _Symbol_bit(_Param)});
+    }
+
+    term_ref application(term_ref _Func, term_ref _Arg)
+    {
+        const term_node& _Left = _Nodes[_Func];
+        const term_node& _Right = _Nodes[_Arg];
+        return _Push({term_kind::application, _Func, _Arg
+            , _Saturating_add(_Saturating_add(_Left.size, _Right.size), 1)
+            , _Left.occurs | _Right.occurs});
+    }
+
+    const term_node& operator[](term_ref _Ref) const noexcept
+    {
+        return _Nodes[_Ref];
+    }
+
+    size_t node_count() const noexcept
+    {
+        return _Nodes.size();
+    }
+
+    void clear() noexcept
+    { // drops every term but keeps the names, so symbols stay valid
+        _Nodes.clear();
+    }
+
+    void reset() noexcept
+    { // drops every term and every name, for an arena that serves unrelated terms one by one
+        _Nodes.clear();
+        _Names.clear();
+        _Primed.clear();
+        if (_Symbols.bucket_count() > 1024) { // clearing costs the buckets, not the names
+            std::unordered_map<std::string, symbol>().swap(_Symbols);
+        } else {
+            _Symbols.clear();
+        }
+    }
+
+    term_ref compact(term_ref _Root)
+    { // drops every node not reachable from _Root and returns its new ref
+        std::vector<term_ref> _Roots{_Root};
+        compact(_Roots);
+        return _Roots[0];
+    }
+
+    void compact(std::vector<term_ref>& _Roots)
+    { // drops every node not reachable from one of _Roots and updates them in place; children
+      // are always older than their parents, so one pass down marks and one pass up copies
+        if (_Roots.empty()) {
+            _Nodes.clear();
+            return;
+        }
+
+        const term_ref _Last = *std::max_element(_Roots.begin(), _Roots.end());
+        std::vector<term_ref> _Remap(static_cast<size_t>(_Last) + 1, _Unreachable);
+        for (const term_ref _Root : _Roots) {
+            _Remap[_Root] = 0;
+        }
+
+        for (term_ref _Idx = _Last + 1; _Idx-- != 0;) {
+            if (_Remap[_Idx] != _Unreachable && _Nodes[_Idx].kind != term_kind::variable) {
+                if (_Nodes[_Idx].kind == term_kind::application) {
+                    _Remap[_Nodes[_Idx].first] = 0;
+                }
+
+                _Remap[_Nodes[_Idx].second] = 0;
+            }
+        }
+
+        term_ref _Next = 0;
+        for (term_ref _Idx = 0; _Idx <= _Last; ++_Idx) {
+            if (_Remap[_Idx] == _Unreachable) {
+                continue;
+            }
+
+            term_node _Node = _Nodes[_Idx];
+            if (_Node.kind != term_kind::variable) {
+                if (_Node.kind == term_kind::application) {
+                    _Node.first = _Remap[_Node.first];
+                }
+
+                _Node.second = _Remap[_Node.second];
+            }
+
+            _Nodes[_Next] = _Node;
+            _Remap[_Idx] = _Next++;
+        }
+
+        _Nodes.resize(_Next);
+        for (term_ref& _Root : _Roots) {
+            _Root = _Remap[_Root];
+        }
+    }
+
+private:
+    static constexpr symbol _No_symbol = std::numeric_limits<symbol>::max();
+    static constexpr term_ref _Unreachable = std::numeric_limits<term_ref>::max();
+
+    term_ref _Push(const term_node& _Node)
+    {
+        if (_Nodes.size() >= std::numeric_limits<term_ref>::max()) {
+            throw std::length_error("term_arena exhausted");
+        }
+
+        _Nodes.push_back(_Node);
+        return static_cast<term_ref>(_Nodes.size() - 1);
+    }
+
+    std::vector<term_node> _Nodes;
+    std::vector<std::string> _Names;
+    std::vector<symbol> _Primed;
+    std::unordered_map<std::string, symbol> _Symbols;
+};
+
+// FUNCTION occurs_free
+inline bool occurs_free(const term_arena& _Arena, term_ref _Term, symbol _Sym)
+{
+    constexpr size_t _Local_size = 32;
+    term_ref _Local[_Local_size]; // arguments still to look at, the rest go to _Overflow
+    size_t _Pending = 0;
+    std::vector<term_ref> _Overflow;
+    for (;;) {
+        const term_node& _Node = _Arena[_Term];
+        if ((_Node.occurs & _Symbol_bit(_Sym)) != 0) {
+            switch (_Node.kind) {
+            case term_kind::variable:
+                if (_Node.first == _Sym) {
+                    return true;
+                }
+                break;
+            case term_kind::lambda:
+                if (_Node.first != _Sym) {
+                    _Term = _Node.second;
+                    continue;
+                }
+                break;
+            default: // application
+                if (_Pending < _Local_size) {
+                    _Local[_Pending] = _Node.second;
+                } else {
+                    _Overflow.push_back(_Node.second);
+                }
+
+                ++_Pending;
+                _Term = _Node.first;
+                continue;
+            }
+        }
+
+        if (_Pending == 0) {
+            return false;
+        }
+
+        if (--_Pending < _Local_size) {
+            _Term = _Local[_Pending];
+        } else {
+            _Term = _Overflow.back();
+            _Overflow.pop_back();
+        }
+    }
+}
+
+template <class _Table>
+void _Collect_free_variables(const term_arena& _Arena, term_ref _Term, _Table& _Bound, _Table& _Seen
+    , std::vector<symbol>& _Result)
+{ // _Table maps a symbol to a count that starts at 0
+    struct _Frame {
+        term_ref _Term;
+        bool _Leaving;
+    };
+    std::vector<_Frame> _Stack{{_Term, false}};
+
+    while (!_Stack.empty()) {
+        const _Frame _Top = _Stack.back();
+        _Stack.pop_back();
+        const term_node& _Node = _Arena[_Top._Term];
+        switch (_Node.kind) {
+        case term_kind::variable:
+            if (_Bound[_Node.first] == 0 && _Seen[_Node.first] == 0) {
+                _Seen[_Node.first] = 1;
+                _Result.push_back(_Node.first);
+            }
+            break;
+        case term_kind::lambda:
+            if (_Top._Leaving) {
+                --_Bound[_Node.first];
+            } else {
+                ++_Bound[_Node.first];
+                _Stack.push_back({_Top._Term, true});
+                _Stack.push_back({_Node.second, false});
+            }
+            break;
+        default: // application
+            _Stack.push_back({_Node.second, false});
+            _Stack.push_back({_Node.first, false});
+            break;
+        }
+    }
+}
+
+// FUNCTION free_variables
+inline std::vector<symbol> free_variables(const term_arena& _Arena, term_ref _Term)
+{ // in order of first occurrence, like `free_variables_t`; in time proportional to the term
+  // however many names the arena holds
+    std::vector<symbol> _Result;
+    if (_Arena.symbol_count() <= _Arena[_Term].size) {
+        std::vector<unsigned> _Bound(_Arena.symbol_count());
+        std::vector<unsigned> _Seen(_Arena.symbol_count());
+        _Collect_free_variables(_Arena, _Term, _Bound, _Seen, _Result);
+    } else { // fewer nodes than names
+        std::unordered_map<symbol, unsigned> _Bound;
+        std::unordered_map<symbol, unsigned> _Seen;
+        _Collect_free_variables(_Arena, _Term, _Bound, _Seen, _Result);
+    }
+
+    return _Result;
+}
+
+// FUNCTION copy_term
+inline term_ref copy_term(term_arena& _To, const term_arena& _From, term_ref _Term)
+{ // copies the nodes reachable from _Term into another arena, matching names by spelling
+    constexpr term_ref _Unreachable = std::numeric_limits<term_ref>::max();
+    std::vector<term_ref> _Remap(static_cast<size_t>(_Term) + 1, _Unreachable);
+    std::vector<symbol> _Names(_From.symbol_count(), std::numeric_limits<symbol>::max());
+    const auto _Name = [&](symbol _Sym) {
+        if (_Names[_Sym] == std::numeric_limits<symbol>::max()) {
+            _Names[_Sym] = _To.intern(_From.name_of(_Sym));
+        }
+
+        return _Names[_Sym];
+    };
+
+    _Remap[_Term] = 0;
+    for (term_ref _Idx = _Term + 1; _Idx-- != 0;) {
+        const term_node& _Node = _From[_Idx];
+        if (_Remap[_Idx] != _Unreachable && _Node.kind != term_kind::variable) {
+            if (_Node.kind == term_kind::application) {
+                _Remap[_Node.first] = 0;
+            }
+
+            _Remap[_Node.second] = 0;
+        }
+    }
+
+    for (term_ref _Idx = 0; _Idx <= _Term; ++_Idx) {
+        if (_Remap[_Idx] == _Unreachable) {
+            continue;
+        }
+
+        const term_node& _Node = _From[_Idx];
+        switch (_Node.kind) {
+        case term_kind::variable:
+            _Remap[_Idx] = _To.variable(_Name(_Node.first));
+            break;
+        case term_kind::lambda:
+            _Remap[_Idx] = _To.lambda(_Name(_Node.first), _Remap[_Node.second]);
+            break;
+        default:
+            _Remap[_Idx] = _To.application(_Remap[_Node.first], _Remap[_Node.second]);
+            break;
+        }
+    }
+
+    return _Remap[_Term];
+}
+
+// FUNCTION alpha_equivalent
+inline bool alpha_equivalent(const term_arena& _Left_arena, term_ref _Left
+    , const term_arena& _Right_arena, term_ref _Right)
+{ // equal up to the names of bound variables; free names are compared by spelling
+    struct _Pair {
+        term_ref _Left;
+        term_ref _Right;
+        size_t _Depth; // binders of both sides in scope
+    };
+    std::vector<symbol> _Left_binders;
+    std::vector<symbol> _Right_binders;
+    std::vector<_Pair> _Stack{{_Left, _Right, 0}};
+    const auto _Level_of = [](const std::vector<symbol>& _Binders, size_t _Depth, symbol _Sym) {
+        for (size_t _Idx = _Depth; _Idx != 0; --_Idx) {
+            if (_Binders[_Idx - 1] == _Sym) {
+                return _Idx;
+            }
+        }
+
+        return size_t{0};
+    };
+
+    while (!_Stack.empty()) {
+        const _Pair _Top = _Stack.back();
+        _Stack.pop_back();
+        const term_node& _Lnode = _Left_arena[_Top._Left];
+        const term_node& _Rnode = _Right_arena[_Top._Right];
+        if (_Lnode.kind != _Rnode.kind || _Lnode.size != _Rnode.size) {
+            return false;
+        }
+
+        _Left_binders.resize(_Top._Depth);
+        _Right_binders.resize(_Top._Depth);
+        switch (_Lnode.kind) {
+        case term_kind::variable:
+        {
+            const size_t _Level = _Level_of(_Left_binders, _Top._Depth, _Lnode.first);
+            if (_Level != _Level_of(_Right_binders, _Top._Depth, _Rnode.first)
+                || (_Level == 0 && _Left_arena.name_of(_Lnode.first) != _Right_arena.name_of(_Rnode.first))) {
+                return false;
+            }
+            break;
+        }
+        case term_kind::lambda:
+            _Left_binders.push_back(_Lnode.first);
+            _Right_binders.push_back(_Rnode.first);
+            _Stack.push_back({_Lnode.second, _Rnode.second, _Top._Depth + 1});
+            break;
+        default:
+            _Stack.push_back({_Lnode.second, _Rnode.second, _Top._Depth});
+            _Stack.push_back({_Lnode.first, _Rnode.first, _Top._Depth});
+            break;
+        }
+    }
+
+    return true;
+}
+
+// CLASS _Substituter
+class _Substituter { // capture-avoiding _Body[_Var <= _Value], sharing untouched subterms
+public:
+    explicit _Substituter(term_arena& _Arena_) noexcept : _Arena(_Arena_) {}
+
+    term_ref operator()(term_ref _Term, symbol _Var, term_ref _Value)
+    { // terms may be far deeper than the thread's stack: a subterm of up to `_Small_size`
+      // nodes, which bounds its depth, is substituted by recursion, anything bigger on
+      // `_Frames`, which a reused substituter keeps
+        if (_Arena[_Term].size <= _Small_size) {
+            return _Small(_Term, _Var, _Value);
+        }
+
+        _Frames.push_back({_Term, _Var, _Value, _Step::_Enter, 0});
+        while (!_Frames.empty()) {
+            const _Frame _Top = _Frames.back(); // copied, pushing may move the frames
+            switch (_Top._Stage) {
+            case _Step::_Enter:
+                _Enter(_Top);
+                break;
+            case _Step::_Renamed:
+            { // lambda(y', a[y <= y']) is ready, substitute into it
+                const term_ref _Body = _Results.back();
+                _Results.pop_back();
+                _Frames.back()._Stage = _Step::_Body;
+                _Descend(_Body, _Top._Var, _Top._Value);
+                break;
+            }
+            case _Step::_Body:
+            {
+                const term_ref _Body = _Results.back();
+                _Results.pop_back();
+                _Frames.pop_back();
+                const term_node& _Node = _Arena[_Top._Term];
+                _Results.push_back(_Body == _Node.second && _Top._Param == _Node.first
+                    ? _Top._Term : _Arena.lambda(_Top._Param, _Body));
+                break;
+            }
+            default: // _Step::_Operands or _Step::_Function
+            {
+                term_ref _Arg;
+                if (_Top._Stage == _Step::_Operands) {
+                    _Arg = _Results.back();
+                    _Results.pop_back();
+                } else {
+                    _Arg = _Small(_Arena[_Top._Term].second, _Top._Var, _Top._Value);
+                }
+
+                const term_ref _Func = _Results.back();
+                _Results.pop_back();
+                _Frames.pop_back();
+                const term_node& _Node = _Arena[_Top._Term];
+                _Results.push_back(_Func == _Node.first && _Arg == _Node.second
+                    ? _Top._Term : _Arena.application(_Func, _Arg));
+                break;
+            }
+            }
+        }
+
+        const term_ref _Result = _Results.back();
+        _Results.pop_back();
+        return _Result;
+    }
+
+private:
+    static constexpr std::uint64_t _Small_size = 128;
+
+    enum class _Step : unsigned char {
+        _Enter,    // nothing done yet
+        _Operands, // both operands of an application substituted, on `_Results`
+        _Function, // only the function, the argument is small
+        _Renamed,  // the body of a lambda with its parameter renamed, on `_Results`
+        _Body      // the body of a lambda substituted, on `_Results`
+    };
+
+    struct _Frame {
+        term_ref _Term;
+        symbol _Var;     // renaming a parameter substitutes another variable inside
+        term_ref _Value;
+        _Step _Stage;
+        symbol _Param;   // the parameter of a lambda, renamed or not
+    };
+
+    symbol _Fresh_param(const term_node& _Lambda, symbol _Var, term_ref _Value)
+    { // lambda(y, a)[x <= b{y}] -> lambda(y', a[y <= y'][x <= b]) // protect inner y
+      // returns y itself when it needs no protection
+        if ((_Arena[_Value].occurs & _Symbol_bit(_Lambda.first)) == 0
+            || !occurs_free(_Arena, _Value, _Lambda.first) || !occurs_free(_Arena, _Lambda.second, _Var)) {
+            return _Lambda.first;
+        }
+
+        symbol _Fresh = _Arena.primed(_Lambda.first);
+        while (occurs_free(_Arena, _Value, _Fresh) || occurs_free(_Arena, _Lambda.second, _Fresh)) {
+            _Fresh = _Arena.primed(_Fresh);
+        }
+
+        return _Fresh;
+    }
+
+    term_ref _Small(term_ref _Term, symbol _Var, term_ref _Value)
+    {
+        const term_node _Node = _Arena[_Term]; // copied, the arena may grow below
+        if ((_Node.occurs & _Symbol_bit(_Var)) == 0) {
+            return _Term;
+        }
+
+        switch (_Node.kind) {
+        case term_kind::variable:
+            return _Node.first == _Var ? _Value : _Term;
+        case term_kind::application:
+        {
+            const term_ref _Func = _Small(_Node.first, _Var, _Value);
+            const term_ref _Arg = _Small(_Node.second, _Var, _Value);
+            return _Func == _Node.first && _Arg == _Node.second
+                ? _Term : _Arena.application(_Func, _Arg);
+        }
+        default: // lambda
+            break;
+        }
+
+        if (_Node.first == _Var) { // lambda(x, a)[x <= b] -> lambda(x, a)
+            return _Term;
+        }
+
+        const symbol _Param = _Fresh_param(_Node, _Var, _Value);
+        const term_ref _Body = _Param == _Node.first
+            ? _Node.second : _Small(_Node.second, _Node.first, _Arena.variable(_Param));
+        const term_ref _New_body = _Small(_Body, _Var, _Value);
+        return _New_body == _Node.second && _Param == _Node.first
+            ? _Term : _Arena.lambda(_Param, _New_body);
+    }
+
+    void _Descend(term_ref _Term, symbol _Var, term_ref _Value)
+    {
+        if (_Arena[_Term].size <= _Small_size) {
+            _Results.push_back(_Small(_Term, _Var, _Value));
+        } else {
+            _Frames.push_back({_Term, _Var, _Value, _Step::_Enter, 0});
+        }
+    }
+
+    void _Enter(const _Frame& _Top)
+    {
+        const term_node _Node = _Arena[_Top._Term]; // copied, the arena may grow below
+        if ((_Node.occurs & _Symbol_bit(_Top._Var)) == 0) {
+            _Finish(_Top._Term);
+            return;
+        }
+
+        if (_Node.kind == term_kind::application) { // the function first, a small argument last
+            if (_Arena[_Node.second].size <= _Small_size) {
+                _Frames.back()._Stage = _Step::_Function;
+            } else {
+                _Frames.back()._Stage = _Step::_Operands;
+                _Frames.push_back({_Node.second, _Top._Var, _Top._Value, _Step::_Enter, 0});
+            }
+
+            _Descend(_Node.first, _Top._Var, _Top._Value);
+            return;
+        }
+
+        // a big term is no variable
+        if (_Node.first == _Top._Var) {
+            _Finish(_Top._Term);
+            return;
+        }
+
+        const symbol _Param = _Fresh_param(_Node, _Top._Var, _Top._Value);
+        _Frames.back()._Param = _Param;
+        if (_Param == _Node.first) {
+            _Frames.back()._Stage = _Step::_Body;
+            _Descend(_Node.second, _Top._Var, _Top._Value);
+        } else {
+            _Frames.back()._Stage = _Step::_Renamed;
+            _Descend(_Node.second, _Node.first, _Arena.variable(_Param));
+        }
+    }
+
+    void _Finish(term_ref _Result)
+    {
+        _Frames.pop_back();
+        _Results.push_back(_Result);
+    }
+
+    term_arena& _Arena;
+    std::vector<_Frame> _Frames;
+    std::vector<term_ref> _Results;
+};
+
+// FUNCTION substitute
+inline term_ref substitute(term_arena& _Arena, term_ref _Body, symbol _Var, term_ref _Value)
+{
+    return _Substituter(_Arena)(_Body, _Var, _Value);
+}
+
+// ENUM CLASS reduction_strategy
+enum class reduction_strategy {
+    normal,      // leftmost-outermost, finds a normal form whenever one exists
+    applicative, // leftmost-innermost, arguments are normalized before substitution
+    full         // repeated parallel passes, exactly what `full_reduction` does
+};
+
+// STRUCT reduction_options
+struct reduction_options {
+    reduction_strategy strategy = reduction_strategy::normal;
+    std::uint64_t fuel = std::numeric_limits<std::uint64_t>::max(); // beta and eta steps
+};
+
+// STRUCT reduction_stats
+struct reduction_stats {
+    std::uint64_t steps = 0;     // beta and eta contractions performed
+    std::uint64_t peak_size = 0; // largest intermediate term, in nodes
+    bool exhausted = false;      // fuel ran out before a normal form was reached
+};
+
+// CLASS _Normalizer
+class _Normalizer { // `start`, then `run` until it returns true; `run` may pause in between
+public:
+    _Normalizer(term_arena& _Arena_, const reduction_options& _Options_, reduction_stats& _Stats_) noexcept
+        : _Arena(_Arena_), _Options(_Options_), _Stats(_Stats_), _Substitute(_Arena_) {}
+
+    term_ref operator()(term_ref _Term)
+    {
+        start(_Term);
+        run();
+        return result();
+    }
+
+    void start(term_ref _Term)
+    {
+        _Frames.clear();
+        _Results.clear();
+        _Spine.clear();
+        _Parked = false;
+        _Record(0, _Term);
+        _Pass = _Stats.steps;
+        _Frames.push_back({_Term, 0, _Step::_Enter});
+    }
+
+    bool run(std::uint64_t _Pause_at_ = std::numeric_limits<std::uint64_t>::max())
+    { // false if it paused before the step that would have taken `steps` past `_Pause_at_`,
+      // true once `result` is the normal form or the last reduct before the fuel ran out
+        _Pause_at = _Pause_at_;
+        _Paused = false;
+        switch (_Options.strategy) {
+        case reduction_strategy::applicative:
+            return _Run<reduction_strategy::applicative>();
+        case reduction_strategy::full:
+            break;
+        default:
+            return _Run<reduction_strategy::normal>();
+        }
+
+        for (;;) {
+            if (!_Run<reduction_strategy::full>()) {
+                return false;
+            }
+
+            if (_Stats.steps == _Pass || _Stats.exhausted) {
+                return true;
+            }
+
+            _Pass = _Stats.steps;
+            _Frames.push_back({_Results.back(), 0, _Step::_Enter});
+            _Results.pop_back();
+        }
+    }
+
+    void stop()
+    { // finishes a paused reduction with the reduct reached so far
+        if (_Parked) { // put the head back into its applications
+            _Parked = false;
+            term_ref _Term = _Head._Term;
+            while (!_Spine.empty()) {
+                _Term = _Rebuild(_Spine.back()._Term, _Term, _Arena[_Spine.back()._Term].second);
+                _Spine.pop_back();
+            }
+
+            _Frames.back()._Term = _Term;
+        }
+
+        _Stats.exhausted = true; // every frame now completes with what it has
+        run();
+    }
+
+    term_ref result() const noexcept
+    {
+        return _Results.back();
+    }
+
+    std::uint64_t size() const noexcept
+    { // of the whole current term
+        return _Size;
+    }
+
+    void compact()
+    { // compacts the arena, keeping what a paused reduction still refers to
+        _Roots.clear();
+        for (const _Frame& _Item : _Frames) {
+            _Roots.push_back(_Item._Term);
+        }
+
+        for (const _Pending& _Item : _Spine) {
+            _Roots.push_back(_Item._Term);
+        }
+
+        _Roots.insert(_Roots.end(), _Results.begin(), _Results.end());
+        if (_Parked) {
+            _Roots.push_back(_Head._Term);
+        }
+
+        _Arena.compact(_Roots);
+        auto _Next = _Roots.begin();
+        for (_Frame& _Item : _Frames) {
+            _Item._Term = *_Next++;
+        }
+
+        for (_Pending& _Item : _Spine) {
+            _Item._Term = *_Next++;
+        }
+
+        for (term_ref& _Item : _Results) {
+            _Item = *_Next++;
+        }
+
+        if (_Parked) {
+            _Head._Term = *_Next;
+        }
+    }
+
+private:
+    // Every helper receives `_Context`, the number of nodes surrounding the subterm it works
+    // on, so that the size of the whole term is known after each contraction. Nothing here
+    // recurses on the shape of the term, a term of any depth fits in the explicit stacks,
+    // and a pause leaves everything there for the next `run`.
+
+    bool _Take_step() noexcept
+    {
+        if (_Stats.exhausted || _Stats.steps >= _Options.fuel) {
+            _Stats.exhausted = true;
+            return false;
+        }
+
+        if (_Stats.steps >= _Pause_at) {
+            _Paused = true;
+            return false;
+        }
+
+        ++_Stats.steps;
+        return true;
+    }
+
+    void _Record(std::uint64_t _Context, term_ref _Term) noexcept
+    {
+        _Size = _Saturating_add(_Context, _Arena[_Term].size);
+        if (_Size > _Stats.peak_size) {
+            _Stats.peak_size = _Size;
+        }
+    }
+
+    term_ref _Beta(term_ref _Func, term_ref _Arg)
+    { // lambda(x, a)(b) -> a[x <= b]
+        const term_node _Node = _Arena[_Func];
+        return _Substitute(_Node.second, _Node.first, _Arg);
+    }
+
+    term_ref _Eta(term_ref _Lambda, symbol _Param, term_ref _Body)
+    { // lambda(x, f(x)) -> f
+      // lambda(x, f{x}(x)) -> lambda(x, f(x))
+        const term_node _Node = _Arena[_Body];
+        if (_Node.kind == term_kind::application
+            && _Arena[_Node.second].kind == term_kind::variable
+            && _Arena[_Node.second].first == _Param
+            && !occurs_free(_Arena, _Node.first, _Param) && _Take_step()) {
+            if (_Size != std::numeric_limits<std::uint64_t>::max()) {
+                _Size -= 3; // the lambda, the application and the variable
+            }
+
+            return _Node.first;
+        }
+
+        return _Body == _Arena[_Lambda].second ? _Lambda : _Arena.lambda(_Param, _Body);
+    }
+
+    std::uint64_t _Beside(std::uint64_t _Context, term_ref _Sibling) const noexcept
+    { // the context of one child of an application, given the other child
+        return _Saturating_add(_Context, _Saturating_add(_Arena[_Sibling].size, 1));
+    }
+
+    term_ref _Rebuild(term_ref _Term, term_ref _Func, term_ref _Arg)
+    {
+        const term_node& _Node = _Arena[_Term];
+        return _Func == _Node.first && _Arg == _Node.second
+            ? _Term : _Arena.application(_Func, _Arg);
+    }
+
+    term_ref _Weak_head(term_ref _Term, std::uint64_t _Context)
+    { // contracts the head redex until there is none, the applications around the head wait
+      // on `_Spine` with their contexts; `_Spine` is empty between calls unless a pause
+      // parked the head in `_Head`
+        if (_Parked) {
+            _Parked = false;
+            _Term = _Head._Term;
+            _Context = _Head._Context;
+        }
+
+        for (;;) {
+            while (_Arena[_Term].kind == term_kind::application) {
+                const term_node& _Node = _Arena[_Term];
+                _Spine.push_back({_Term, _Context});
+                _Context = _Beside(_Context, _Node.second);
+                _Term = _Node.first;
+            }
+
+            if (_Spine.empty() || _Arena[_Term].kind != term_kind::lambda || !_Take_step()) {
+                break;
+            }
+
+            const _Pending _Redex = _Spine.back();
+            _Spine.pop_back();
+            _Context = _Redex._Context;
+            _Term = _Beta(_Term, _Arena[_Redex._Term].second);
+            _Record(_Context, _Term);
+        }
+
+        if (_Paused) {
+            _Parked = true;
+            _Head = {_Term, _Context};
+            return _Term;
+        }
+
+        while (!_Spine.empty()) {
+            const term_ref _App = _Spine.back()._Term;
+            _Spine.pop_back();
+            _Term = _Rebuild(_App, _Term, _Arena[_App].second);
+        }
+
+        return _Term;
+    }
+
+    template <reduction_strategy _Strategy>
+    bool _Run()
+    { // `normal`: the weak head normal form, then its parts from left to right
+      // `applicative`: both sides of an application first, then contract it, and again
+      // `full`: one round of `_Full_reduction_impl`, both sides first and one contraction
+        while (!_Frames.empty()) {
+            if (_Paused) {
+                return false;
+            }
+
+            const _Frame _Top = _Frames.back(); // copied, pushing may move the frames
+            switch (_Top._Stage) {
+            case _Step::_Enter:
+                _Enter<_Strategy>(_Top._Term, _Top._Context);
+                break;
+            case _Step::_Function:
+                _Frames.back()._Stage = _Step::_Argument;
+                _Descend(_Arena[_Top._Term].second, _Beside(_Top._Context, _Results.back()));
+                break;
+            case _Step::_Argument:
+            {
+                const term_ref _Func = _Results[_Results.size() - 2];
+                const term_ref _Arg = _Results.back();
+                if (_Strategy != reduction_strategy::normal // the head of a normal form is neutral
+                    && _Arena[_Func].kind == term_kind::lambda && _Take_step()) {
+                    _Results.resize(_Results.size() - 2);
+                    const term_ref _Contracted = _Beta(_Func, _Arg);
+                    _Record(_Top._Context, _Contracted);
+                    if (_Strategy == reduction_strategy::applicative) {
+                        _Frames.back() = {_Contracted, _Top._Context, _Step::_Enter};
+                    } else {
+                        _Finish(_Contracted);
+                    }
+                } else if (!_Paused) {
+                    _Results.resize(_Results.size() - 2);
+                    _Finish(_Rebuild(_Top._Term, _Func, _Arg));
+                }
+
+                break;
+            }
+            default: // _Step::_Body
+            {
+                const term_ref _Body = _Eta(_Top._Term, _Arena[_Top._Term].first, _Results.back());
+                if (!_Paused) {
+                    _Results.pop_back();
+                    _Finish(_Body);
+                }
+
+                break;
+            }
+            }
+        }
+
+        return true;
+    }
+
+    template <reduction_strategy _Strategy>
+    void _Enter(term_ref _Term, std::uint64_t _Context)
+    { // descends along new frames until a variable completes one
+        for (;;) {
+            if (_Stats.exhausted) {
+                _Finish(_Term);
+                return;
+            }
+
+            if (_Strategy == reduction_strategy::normal) {
+                _Term = _Weak_head(_Term, _Context);
+                if (_Paused) {
+                    return;
+                }
+
+                _Frames.back()._Term = _Term;
+            }
+
+            const term_node& _Node = _Arena[_Term];
+            switch (_Node.kind) {
+            case term_kind::variable:
+                _Finish(_Term);
+                return;
+            case term_kind::lambda:
+                _Frames.back()._Stage = _Step::_Body;
+                _Term = _Node.second;
+                _Context = _Saturating_add(_Context, 1);
+                break;
+            default:
+                _Frames.back()._Stage = _Step::_Function;
+                _Context = _Beside(_Context, _Node.second);
+                _Term = _Node.first;
+                break;
+            }
+
+            if (_Arena[_Term].kind == term_kind::variable) {
+                _Results.push_back(_Term);
+                return;
+            }
+
+            _Frames.push_back({_Term, _Context, _Step::_Enter});
+        }
+    }
+
+    void _Descend(term_ref _Term, std::uint64_t _Context)
+    { // a variable is its own normal form and needs no frame
+        if (_Arena[_Term].kind == term_kind::variable) {
+            _Results.push_back(_Term);
+        } else {
+            _Frames.push_back({_Term, _Context, _Step::_Enter});
+        }
+    }
+
+    void _Finish(term_ref _Result)
+    {
+        _Frames.pop_back();
+        _Results.push_back(_Result);
+    }
+
+    enum class _Step : unsigned char {
+        _Enter,    // nothing done yet
+        _Function, // the function of an application reduced, on `_Results`
+        _Argument, // the argument too
+        _Body      // the body of a lambda reduced, on `_Results`
+    };
+
+    struct _Frame {
+        term_ref _Term;
+        std::uint64_t _Context;
+        _Step _Stage;
+    };
+
+    struct _Pending {
+        term_ref _Term; // an application whose function is being reduced
+        std::uint64_t _Context;
+    };
+
+    term_arena& _Arena;
+    const reduction_options& _Options;
+    reduction_stats& _Stats;
+    _Substituter _Substitute;
+    std::vector<_Frame> _Frames;
+    std::vector<term_ref> _Results;
+    std::vector<_Pending> _Spine;
+    std::vector<term_ref> _Roots;     // scratch for `compact`
+    _Pending _Head{};                 // the parked head of `_Spine`
+    bool _Parked = false;
+    bool _Paused = false;
+    std::uint64_t _Pause_at = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t _Pass = 0;          // `full`: the steps when the current round began
+    std::uint64_t _Size = 0;
+};
+
+// FUNCTION normalize
+inline term_ref normalize(term_arena& _Arena, term_ref _Term
+    , const reduction_options& _Options, reduction_stats& _Stats)
+{
+    return _Normalizer(_Arena, _Options, _Stats)(_Term);
+}
+
+inline term_ref normalize(term_arena& _Arena, term_ref _Term)
+{
+    reduction_stats _Stats;
+    return normalize(_Arena, _Term, reduction_options{}, _Stats);
+}
+
+// CLASS parse_error
+class parse_error : public std::runtime_error {
+public:
+    parse_error(const char* _Message, size_t _Position_)
+        : std::runtime_error(_Message), _Position(_Position_) {}
+
+    size_t position() const noexcept
+    { // offset into the parsed text
+        return _Position;
+    }
+
+private:
+    size_t _Position;
+};
+
+// CLASS _Parser
+class _Parser { // the grammar of `operator<<`:
+                // term := name | '(' term term+ ')' | '[' "lambda" name '.' term ']'
+                // where name := [A-Za-z_][A-Za-z0-9_]* '\''*
+public:
+    _Parser(term_arena& _Arena_, std::string_view _Text_) noexcept
+        : _Arena(_Arena_), _Text(_Text_) {}
+
+    term_ref operator()()
+    {
+        const term_ref _Result = _Term();
+        _Skip_space();
+        if (_Pos != _Text.size()) {
+            throw parse_error("unexpected trailing input", _Pos);
+        }
+
+        return _Result;
+    }
+
+private:
+    static bool _Is_name_start(char _Ch) noexcept
+    {
+        return (_Ch >= 'a' && _Ch <= 'z') || (_Ch >= 'A' && _Ch <= 'Z') || _Ch == '_';
+    }
+
+    static bool _Is_name_char(char _Ch) noexcept
+    {
+        return _Is_name_start(_Ch) || (_Ch >= '0' && _Ch <= '9');
+    }
+
+    void _Skip_space() noexcept
+    {
+        while (_Pos < _Text.size() && (_Text[_Pos] == ' ' || _Text[_Pos] == '\t'
+            || _Text[_Pos] == '\r' || _Text[_Pos] == '\n')) {
+            ++_Pos;
+        }
+    }
+
+    void _Expect(char _Ch)
+    {
+        _Skip_space();
+        if (_Pos == _Text.size() || _Text[_Pos] != _Ch) {
+            throw parse_error(_Ch == ')' ? "expected ')'" : _Ch == ']' ? "expected ']'"
+                : _Ch == '.' ? "expected '.'" : "unexpected character", _Pos);
+        }
+
+        ++_Pos;
+    }
+
+    std::string_view _Name()
+    {
+        _Skip_space();
+        const size_t _Start = _Pos;
+        if (_Pos == _Text.size() || !_Is_name_start(_Text[_Pos])) {
+            throw parse_error("expected a variable name", _Pos);
+        }
+
+        while (_Pos < _Text.size() && _Is_name_char(_Text[_Pos])) {
+            ++_Pos;
+        }
+
+        while (_Pos < _Text.size() && _Text[_Pos] == '\'') {
+            ++_Pos;
+        }
+
+        return _Text.substr(_Start, _Pos - _Start);
+    }
+
+    bool _At_term_end() noexcept
+    {
+        _Skip_space();
+        return _Pos == _Text.size() || _Text[_Pos] == ')';
+    }
+
+    term_ref _Term()
+    { // the constructs still open wait on an explicit stack, nesting is only bounded by memory
+        _Open.clear();
+        for (;;) {
+            _Skip_space();
+            if (_Pos == _Text.size()) {
+                throw parse_error("unexpected end of input", _Pos);
+            }
+
+            if (_Text[_Pos] == '(') {
+                ++_Pos;
+                _Open.push_back({false, 0, 0, false});
+                continue;
+            }
+
+            if (_Text[_Pos] == '[') {
+                ++_Pos;
+                if (_Name() != "lambda") {
+                    throw parse_error("expected \"lambda\"", _Pos);
+                }
+
+                const symbol _Param = _Arena.intern(_Name());
+                _Expect('.');
+                _Open.push_back({true, _Param, 0, false});
+                continue;
+            }
+
+            term_ref _Done = _Arena.variable(_Arena.intern(_Name()));
+            for (;;) { // close every construct that _Done completes
+                if (_Open.empty()) {
+                    return _Done;
+                }
+
+                _Construct& _Top = _Open.back();
+                if (_Top._Lambda) {
+                    _Expect(']');
+                    _Done = _Arena.lambda(_Top._Param, _Done);
+                    _Open.pop_back();
+                    continue;
+                }
+
+                if (!_Top._Has_func) {
+                    _Top._Func = _Done;
+                    _Top._Has_func = true;
+                    if (_At_term_end()) {
+                        throw parse_error("application needs an argument", _Pos);
+                    }
+
+                    break;
+                }
+
+                _Top._Func = _Arena.application(_Top._Func, _Done); // (f a b) is read as ((f a) b)
+                if (!_At_term_end()) {
+                    break;
+                }
+
+                _Expect(')');
+                _Done = _Top._Func;
+                _Open.pop_back();
+            }
+        }
+    }
+
+    struct _Construct {
+        bool _Lambda;
+        symbol _Param;   // lambda
+        term_ref _Func;  // application: the applications read so far
+        bool _Has_func;
+    };
+
+    term_arena& _Arena;
+    std::string_view _Text;
+    size_t _Pos = 0;
+    std::vector<_Construct> _Open;
+};
+
+// FUNCTION parse_term
+inline term_ref parse_term(term_arena& _Arena, std::string_view _Text)
+{
+    return _Parser(_Arena, _Text)();
+}
+
+// FUNCTION append_term
+inline void append_term(std::string& _Out, const term_arena& _Arena, term_ref _Term)
+{ // writes the same text as `operator<<` of the compile-time nodes
+    struct _Piece {
+        term_ref _Term;
+        const char* _Text; // written instead of _Term unless null
+    };
+    std::vector<_Piece> _Stack{{_Term, nullptr}};
+
+    while (!_Stack.empty()) {
+        const _Piece _Top = _Stack.back();
+        _Stack.pop_back();
+        if (_Top._Text) {
+            _Out += _Top._Text;
+            continue;
+        }
+
+        const term_node& _Node = _Arena[_Top._Term];
+        switch (_Node.kind) {
+        case term_kind::variable:
+            _Out += _Arena.name_of(_Node.first);
+            break;
+        case term_kind::lambda:
+            _Out += "[lambda ";
+            _Out += _Arena.name_of(_Node.first);
+            _Out += ". ";
+            _Stack.push_back({0, "]"});
+            _Stack.push_back({_Node.second, nullptr});
+            break;
+        default:
+            _Out += '(';
+            _Stack.push_back({0, ")"});
+            _Stack.push_back({_Node.second, nullptr});
+            _Stack.push_back({0, " "});
+            _Stack.push_back({_Node.first, nullptr});
+            break;
+        }
+    }
+}
+
+// FUNCTION to_string
+inline std::string to_string(const term_arena& _Arena, term_ref _Term)
+{
+    std::string _Result;
+    append_term(_Result, _Arena, _Term);
+    return _Result;
+}
+
+// FUNCTION TEMPLATE to_runtime
+template <class _ExprTy, std::enable_if_t<is_nightly_lambda_v<_ExprTy>, int> = 0>
+term_ref to_runtime(term_arena& _Arena, const _ExprTy&)
+{ // lifts a compile-time term into the arena through its printed form
+    return parse_term(_Arena, std_ext::to_string_constant<typename _ExprTy::self::_Char_seq_rep>::value);
+}
+
+} // namespace runtime
+} // namespace nightly_lambda
+
+#endif // header guard
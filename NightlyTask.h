@@ -0,0 +1,284 @@
+// NightlyTask.h - implements resumable runtime evaluation with step budgets,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// `normalize` runs to completion, which is fine for a batch but not for a server thread
+// that may meet a divergent term. `evaluate_incrementally` returns an `evaluation_task`,
+// a C++20 coroutine that owns its own `term_arena` and reduces in slices of at most
+// `steps_per_slice` steps. After every slice it suspends with a `task_progress` snapshot;
+// the caller resumes it, cancels it or lets its deadline expire. The reducer lives in the
+// coroutine frame and pauses with its explicit stacks intact, so the next slice continues
+// exactly where the last one stopped and costs what its steps cost, not a walk over the
+// whole term. Between slices the arena is compacted now and then, keeping what the paused
+// reducer refers to, so a long evaluation holds the live term and not its history.
+//
+//     auto _Task = evaluate_incrementally(_Arena, _Term, {reduction_strategy::normal, 1000});
+//     while (_Task.resume()) {
+//         // requeue _Task, inspect _Task.progress() ...
+//     }
+//
+// A task may be resumed on any thread, but by one thread at a time; `cancel` and
+// `set_deadline` may be called from anywhere.
+
+#pragma once
+#ifndef YUAN_NIGHTLY_TASK
+#define YUAN_NIGHTLY_TASK
+
+#include "NightlyRuntime.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <utility>
+
+#if !defined(__cpp_impl_coroutine) && !(defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#error NightlyTask.h requires C++20 coroutines
+#endif
+#include <coroutine>
+
+namespace nightly_lambda {
+namespace runtime {
+
+// ENUM CLASS task_status
+enum class task_status {
+    running,         // suspended between slices, resume to continue
+    normal_form,     // finished, `result` is the normal form
+    out_of_fuel,     // finished, the total fuel ran out first
+    cancelled,       // finished, `cancel` was called
+    deadline_expired // finished, the deadline passed
+};
+
+// STRUCT task_options
+struct task_options {
+    reduction_strategy strategy = reduction_strategy::normal;
+    std::uint64_t steps_per_slice = 1024;
+    std::uint64_t fuel = std::numeric_limits<std::uint64_t>::max();
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+};
+
+// STRUCT task_progress
+struct task_progress {
+    task_status status = task_status::running;
+    std::uint64_t steps = 0;     // in all slices so far
+    std::uint64_t size = 0;      // of the current term, in nodes
+    std::uint64_t peak_size = 0;
+    std::uint64_t slices = 0;
+};
+
+// CLASS evaluation_task
+class evaluation_task {
+public:
+    struct promise_type {
+        term_arena arena;
+        term_ref current = 0;
+        task_progress progress;
+        std::atomic<std::chrono::steady_clock::rep> deadline; // in ticks since the epoch
+        std::atomic<bool> cancel_requested{false};
+        std::exception_ptr error;
+
+        promise_type(const term_arena& _Source, term_ref _Term, const task_options& _Options)
+            : deadline(_Options.deadline.time_since_epoch().count())
+        {
+            current = copy_term(arena, _Source, _Term);
+            progress.size = arena[current].size;
+            progress.peak_size = progress.size;
+        }
+
+        evaluation_task get_return_object() noexcept
+        {
+            return evaluation_task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() const noexcept
+        { // nothing runs before the first `resume`
+            return {};
+        }
+
+        std::suspend_always final_suspend() const noexcept
+        { // keep the frame, the arena holds the result
+            return {};
+        }
+
+        std::suspend_always yield_value(const task_progress&) const noexcept
+        {
+            return {};
+        }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() noexcept
+        {
+            error = std::current_exception();
+        }
+    };
+
+    evaluation_task() = default;
+
+    evaluation_task(evaluation_task&& _Other) noexcept
+        : _Handle(std::exchange(_Other._Handle, nullptr)) {}
+
+    evaluation_task& operator=(evaluation_task&& _Other) noexcept
+    {
+        if (this != &_Other) {
+            _Destroy();
+            _Handle = std::exchange(_Other._Handle, nullptr);
+        }
+
+        return *this;
+    }
+
+    ~evaluation_task()
+    {
+        _Destroy();
+    }
+
+    bool resume()
+    { // runs one slice, returns false once the task has finished
+        if (!_Handle || _Handle.done()) {
+            return false;
+        }
+
+        _Handle.resume();
+        if (_Handle.promise().error) {
+            std::rethrow_exception(std::exchange(_Handle.promise().error, nullptr));
+        }
+
+        return !_Handle.done();
+    }
+
+    void cancel() noexcept
+    { // takes effect at the next `resume`
+        if (_Handle) {
+            _Handle.promise().cancel_requested.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    void set_deadline(std::chrono::steady_clock::time_point _Deadline) noexcept
+    { // takes effect at the next `resume`, like `cancel`
+        if (_Handle) {
+            _Handle.promise().deadline.store(_Deadline.time_since_epoch().count(), std::memory_order_relaxed);
+        }
+    }
+
+    bool done() const noexcept
+    {
+        return !_Handle || _Handle.done();
+    }
+
+    const task_progress& progress() const noexcept
+    { // an empty task reports no progress
+        static const task_progress _Empty;
+        return _Handle ? _Handle.promise().progress : _Empty;
+    }
+
+    task_status status() const noexcept
+    {
+        return progress().status;
+    }
+
+    const term_arena& arena() const noexcept
+    { // an empty task has an empty arena
+        static const term_arena _Empty;
+        return _Handle ? _Handle.promise().arena : _Empty;
+    }
+
+    term_ref result() const noexcept
+    { // the normal form once `status` is `normal_form`, the last reduct once finished
+      // otherwise, the original term while still running; 0 and not to be read for an empty task
+        return _Handle ? _Handle.promise().current : 0;
+    }
+
+private:
+    explicit evaluation_task(std::coroutine_handle<promise_type> _Handle_) noexcept
+        : _Handle(_Handle_) {}
+
+    void _Destroy() noexcept
+    {
+        if (_Handle) {
+            _Handle.destroy();
+            _Handle = nullptr;
+        }
+    }
+
+    std::coroutine_handle<promise_type> _Handle = nullptr;
+};
+
+// STRUCT _Promise_access
+struct _Promise_access { // lets the coroutine body reach its own promise
+    evaluation_task::promise_type* promise = nullptr;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<evaluation_task::promise_type> _Handle) noexcept
+    {
+        promise = &_Handle.promise();
+        return false; // never actually suspends
+    }
+
+    evaluation_task::promise_type& await_resume() const noexcept
+    {
+        return *promise;
+    }
+};
+
+// FUNCTION evaluate_incrementally
+inline evaluation_task evaluate_incrementally(const term_arena&, term_ref
+    , task_options _Options = task_options{})
+{ // the promise copies the term into its own arena when the task is created, so the
+  // caller's arena may change or go away afterwards
+    evaluation_task::promise_type& _Promise = co_await _Promise_access{};
+    task_progress& _Progress = _Promise.progress;
+    term_arena& _Arena = _Promise.arena;
+    const reduction_options _Reduction{_Options.strategy, _Options.fuel};
+    reduction_stats _Stats;
+    _Normalizer _Reducer(_Arena, _Reduction, _Stats);
+    _Reducer.start(_Promise.current);
+    size_t _Live = _Arena.node_count(); // after the last compaction
+
+    for (;;) {
+        if (_Promise.cancel_requested.load(std::memory_order_relaxed)) {
+            _Progress.status = task_status::cancelled;
+            break;
+        }
+
+        if (std::chrono::steady_clock::now().time_since_epoch().count()
+            >= _Promise.deadline.load(std::memory_order_relaxed)) {
+            _Progress.status = task_status::deadline_expired;
+            break;
+        }
+
+        const std::uint64_t _Pause_at = _Stats.steps + std::min(_Options.steps_per_slice
+            , std::numeric_limits<std::uint64_t>::max() - _Stats.steps);
+        const bool _Finished = _Reducer.run(_Pause_at);
+        ++_Progress.slices;
+        _Progress.steps = _Stats.steps;
+        _Progress.size = _Reducer.size();
+        _Progress.peak_size = std::max(_Progress.peak_size, _Stats.peak_size);
+        if (_Finished) {
+            _Progress.status = _Stats.exhausted ? task_status::out_of_fuel : task_status::normal_form;
+            _Promise.current = _Arena.compact(_Reducer.result());
+            _Progress.size = _Arena[_Promise.current].size;
+            co_return;
+        }
+
+        if (_Arena.node_count() > 2 * _Live + 4096) {
+            _Reducer.compact();
+            _Live = _Arena.node_count();
+        }
+
+        co_yield _Progress;
+    }
+
+    _Reducer.stop(); // the reduct so far
+    _Promise.current = _Arena.compact(_Reducer.result());
+    _Progress.size = _Arena[_Promise.current].size;
+}
+
+} // namespace runtime
+} // namespace nightly_lambda
+
+#endif // header guard
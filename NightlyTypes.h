@@ -0,0 +1,352 @@
+// NightlyTypes.h - implements compile-time simple type inference for lambda terms,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// `full_reduction` has no termination guarantee, and a divergent term only shows up as the
+// compiler running out of instantiation depth. Every simply typed term is strongly
+// normalizing, though, so a term that can be given a simple type is certain to terminate.
+// `principal_type` infers the most general such type, the way Hindley-Milner does without
+// `let`: each binder and each application result gets a fresh `type_variable`, and an
+// application unifies the function type with an arrow from the argument type. Free variables
+// of the term get type variables of their own. The only way to fail is the occurs check
+// (x x needs a = a -> b), which is reported by a `static_assert` instead of a wall of
+// instantiation errors.
+//
+// A `fix(f, a)` has the type t that a has when f : t, as if `fix` were a constant of type
+// (t -> t) -> t, and a closure a[x <= b] is typed as the redex (lambda(x, a))(b) it stands
+// for. Recursion breaks the termination argument, but only for `lazy_evaluate`: `evaluate`
+// never unrolls a `fix_node`, so to it the node is as good as a variable.
+//
+// `checked_evaluate` is `evaluate` behind that check. Terms built with `lambda` and
+// `operator()` are reduced when they are built, so the check matters for expression types
+// assembled by hand from `application_node` and `lambda_node`.
+
+#pragma once
+#ifndef YUAN_NIGHTLY_TYPES
+#define YUAN_NIGHTLY_TYPES
+
+#include "NightlyLambda.h"
+
+namespace nightly_lambda {
+
+class simple_type_tag {};
+
+template <size_t _N>
+struct _Decimal_digits { // _N in decimal, for type variables past 'z'
+    using type = std_ext::concat_integer_sequences<char, typename _Decimal_digits<_N / 10>::type
+        , std_ext::char_sequence<static_cast<char>('0' + _N % 10)>>;
+};
+
+template <>
+struct _Decimal_digits<0> {
+    using type = std_ext::char_sequence<>;
+};
+
+// STRUCT TEMPLATE type_variable
+template <size_t _N>
+struct type_variable {
+    using tag = simple_type_tag;
+    static constexpr size_t number = _N;
+
+    using _Char_seq_rep = std_ext::concat_integer_sequences<char
+        , std_ext::char_sequence<static_cast<char>('a' + _N % 26)>
+        , typename _Decimal_digits<_N / 26>::type>;
+};
+
+template <class _ArgTy, class _ResultTy>
+struct arrow_type;
+
+template <class _Ty>
+struct _Is_arrow_type : std::false_type {};
+
+template <class _ArgTy, class _ResultTy>
+struct _Is_arrow_type<arrow_type<_ArgTy, _ResultTy>> : std::true_type {};
+
+// STRUCT TEMPLATE arrow_type
+template <class _ArgTy, class _ResultTy>
+struct arrow_type {
+    using tag = simple_type_tag;
+    using argument_type = _ArgTy;
+    using result_type = _ResultTy;
+
+    using _Char_seq_rep = std_ext::concat_integer_sequences<char
+        , std::conditional_t<_Is_arrow_type<_ArgTy>::value // arrows associate to the right
+            , std_ext::concat_integer_sequences<char, std_ext::char_sequence<'('>
+                , typename _ArgTy::_Char_seq_rep, std_ext::char_sequence<')'>>
+            , typename _ArgTy::_Char_seq_rep>
+        , std_ext::char_sequence<' ', '-', '>', ' '>
+        , typename _ResultTy::_Char_seq_rep>;
+};
+
+// STRUCT TEMPLATE is_simple_type
+template <class _Ty, class = void>
+struct is_simple_type : std::false_type {};
+
+template <class _Ty>
+struct is_simple_type<_Ty, std::void_t<typename _Ty::tag>>
+    : std::is_same<typename _Ty::tag, simple_type_tag> {};
+
+template <class _Ty>
+constexpr bool is_simple_type_v = is_simple_type<_Ty>::value;
+
+struct _Infer_failed {}; // replaces the substitution once the occurs check fails
+
+template <class _Key, class _Value>
+struct _Binding {};
+
+template <class _Key, class _List>
+struct _Lookup { // not found
+    static constexpr bool has_found = false;
+};
+
+template <class _Key, class _Value, class... _Rest>
+struct _Lookup<_Key, std_ext::type_list<_Binding<_Key, _Value>, _Rest...>> {
+    static constexpr bool has_found = true;
+    using type = _Value;
+};
+
+template <class _Key, class _First, class... _Rest>
+struct _Lookup<_Key, std_ext::type_list<_First, _Rest...>>
+    : _Lookup<_Key, std_ext::type_list<_Rest...>> {};
+
+template <class _Ty, class _Subst, class = void>
+struct _Walk { // arrow or unbound variable
+    using type = _Ty;
+};
+
+template <size_t _N, class _Subst>
+struct _Walk<type_variable<_N>, _Subst, std::enable_if_t<_Lookup<type_variable<_N>, _Subst>::has_found>>
+{ // follow the bindings of a variable
+    using type = typename _Walk<typename _Lookup<type_variable<_N>, _Subst>::type, _Subst>::type;
+};
+
+template <class _Ty, class _Subst>
+using _Walk_t = typename _Walk<_Ty, _Subst>::type;
+
+template <class _Ty, class _Subst>
+struct _Resolve { // unbound variable, after _Walk
+    using type = _Ty;
+};
+
+template <class _Ty, class _Subst>
+using _Resolve_t = typename _Resolve<_Walk_t<_Ty, _Subst>, _Subst>::type;
+
+template <class _ArgTy, class _ResultTy, class _Subst>
+struct _Resolve<arrow_type<_ArgTy, _ResultTy>, _Subst> { // applies the substitution all the way down
+    using type = arrow_type<_Resolve_t<_ArgTy, _Subst>, _Resolve_t<_ResultTy, _Subst>>;
+};
+
+template <class _VarTy, class _Ty, class _Subst>
+struct _Occurs : std::is_same<_VarTy, _Ty> {}; // _Ty is walked
+
+template <class _VarTy, class _ArgTy, class _ResultTy, class _Subst>
+struct _Occurs<_VarTy, arrow_type<_ArgTy, _ResultTy>, _Subst>
+    : std::bool_constant<_Occurs<_VarTy, _Walk_t<_ArgTy, _Subst>, _Subst>::value
+        || _Occurs<_VarTy, _Walk_t<_ResultTy, _Subst>, _Subst>::value> {};
+
+template <class _Left, class _Right, class _Subst>
+struct _Unify_walked;
+
+template <class _Left, class _Right, class _Subst>
+struct _Unify {
+    using type = typename _Unify_walked<_Walk_t<_Left, _Subst>, _Walk_t<_Right, _Subst>, _Subst>::type;
+};
+
+template <class _Left, class _Right>
+struct _Unify<_Left, _Right, _Infer_failed> {
+    using type = _Infer_failed;
+};
+
+template <class _VarTy, class _Ty, class _Subst>
+struct _Bind_variable { // a := t unless a occurs in t
+    using type = std::conditional_t<_Occurs<_VarTy, _Ty, _Subst>::value
+        , _Infer_failed, typename _Subst::template append<_Binding<_VarTy, _Ty>>>;
+};
+
+template <size_t _N, class _Subst>
+struct _Unify_walked<type_variable<_N>, type_variable<_N>, _Subst> {
+    using type = _Subst;
+};
+
+template <size_t _N, size_t _M, class _Subst>
+struct _Unify_walked<type_variable<_N>, type_variable<_M>, _Subst> {
+    using type = typename _Subst::template append<_Binding<type_variable<_N>, type_variable<_M>>>;
+};
+
+template <size_t _N, class _ArgTy, class _ResultTy, class _Subst>
+struct _Unify_walked<type_variable<_N>, arrow_type<_ArgTy, _ResultTy>, _Subst>
+    : _Bind_variable<type_variable<_N>, arrow_type<_ArgTy, _ResultTy>, _Subst> {};
+
+template <class _ArgTy, class _ResultTy, size_t _N, class _Subst>
+struct _Unify_walked<arrow_type<_ArgTy, _ResultTy>, type_variable<_N>, _Subst>
+    : _Bind_variable<type_variable<_N>, arrow_type<_ArgTy, _ResultTy>, _Subst> {};
+
+template <class _Arg1, class _Result1, class _Arg2, class _Result2, class _Subst>
+struct _Unify_walked<arrow_type<_Arg1, _Result1>, arrow_type<_Arg2, _Result2>, _Subst> {
+    using type = typename _Unify<_Result1, _Result2, typename _Unify<_Arg1, _Arg2, _Subst>::type>::type;
+};
+
+template <class _ExprTy, class _Context, class _Subst, size_t _Next>
+struct _Infer { // variable, _Context lists the binders innermost first
+    static_assert(is_variable_v<_ExprTy>, "invalid _ExprTy");
+
+    using type = typename _Lookup<typename _ExprTy::self, _Context>::type;
+    using subst = _Subst;
+    static constexpr size_t next = _Next;
+};
+
+template <class _VarTy, class _ExprTy, class _Context, class _Subst, size_t _Next>
+struct _Infer<lambda_node<_VarTy, _ExprTy>, _Context, _Subst, _Next>
+{ // lambda(x, a) : t -> type(a), x : t
+    using _Param = type_variable<_Next>;
+    using _Body = _Infer<typename _ExprTy::self, std_ext::type_forward_after_t<_Context
+        , std_ext::type_list, _Binding<typename _VarTy::self, _Param>>, _Subst, _Next + 1>;
+
+    using type = arrow_type<_Param, typename _Body::type>;
+    using subst = typename _Body::subst;
+    static constexpr size_t next = _Body::next;
+};
+
+template <class _FuncTy, class _ArgTy, class _Context, class _Subst, size_t _Next>
+struct _Infer<application_node<_FuncTy, _ArgTy>, _Context, _Subst, _Next>
+{ // f(a) : r, where type(f) = type(a) -> r
+    using _Func = _Infer<typename _FuncTy::self, _Context, _Subst, _Next>;
+    using _Arg = _Infer<typename _ArgTy::self, _Context, typename _Func::subst, _Func::next>;
+
+    using type = type_variable<_Arg::next>;
+    using subst = typename _Unify<typename _Func::type
+        , arrow_type<typename _Arg::type, type>, typename _Arg::subst>::type;
+    static constexpr size_t next = _Arg::next + 1;
+};
+
+template <class _VarTy, class _ExprTy, class _Context, class _Subst, size_t _Next>
+struct _Infer<fix_node<_VarTy, _ExprTy>, _Context, _Subst, _Next>
+{ // fix(f, a) : t, where type(a) = t with f : t
+    using _Self = type_variable<_Next>;
+    using _Body = _Infer<typename _ExprTy::self, std_ext::type_forward_after_t<_Context
+        , std_ext::type_list, _Binding<typename _VarTy::self, _Self>>, _Subst, _Next + 1>;
+
+    using type = _Self;
+    using subst = typename _Unify<typename _Body::type, _Self, typename _Body::subst>::type;
+    static constexpr size_t next = _Body::next;
+};
+
+template <class _ExprTy, class... _Substs>
+struct _Closure_redexes { // a
+    using type = _ExprTy;
+};
+
+template <class _ExprTy, class _First, class... _Rest>
+struct _Closure_redexes<_ExprTy, _First, _Rest...>
+{ // a[x <= b][s...] -> (lambda(x, a)(b))[s...], in which s... applies to a and b alike
+    using type = typename _Closure_redexes<application_node<lambda_node<typename _First::prim::self
+        , _ExprTy>, typename _First::sec::self>, _Rest...>::type;
+};
+
+template <class _ExprTy, class... _Substs, class _Context, class _Subst, size_t _Next>
+struct _Infer<closure_node<_ExprTy, std_ext::type_list<_Substs...>>, _Context, _Subst, _Next>
+    : _Infer<typename _Closure_redexes<typename _ExprTy::self, _Substs...>::type
+        , _Context, _Subst, _Next> {};
+
+template <class _Ty, class _Seen>
+struct _Canonical; // renames type variables to a, b, c... in order of appearance
+
+template <size_t _N, class... _Seen>
+struct _Canonical<type_variable<_N>, std_ext::type_list<_Seen...>> {
+    using _List = std::conditional_t<std_ext::type_list<_Seen...>::template contains<type_variable<_N>>
+        , std_ext::type_list<_Seen...>, std_ext::type_list<_Seen..., type_variable<_N>>>;
+    using type = type_variable<_List::template index_of<type_variable<_N>>>;
+    using seen = _List;
+};
+
+template <class _ArgTy, class _ResultTy, class _Seen>
+struct _Canonical<arrow_type<_ArgTy, _ResultTy>, _Seen> {
+    using _Arg = _Canonical<_ArgTy, _Seen>;
+    using _Result = _Canonical<_ResultTy, typename _Arg::seen>;
+    using type = arrow_type<typename _Arg::type, typename _Result::type>;
+    using seen = typename _Result::seen;
+};
+
+template <class _FreeVars>
+struct _Free_variable_context;
+
+template <class... _FreeVars>
+struct _Free_variable_context<std_ext::type_list<_FreeVars...>> { // a type variable for each
+    template <class _Indices>
+    struct _Bind;
+
+    template <size_t... _Indices>
+    struct _Bind<std::index_sequence<_Indices...>> {
+        using type = std_ext::type_list<_Binding<_FreeVars, type_variable<_Indices>>...>;
+    };
+
+    using type = typename _Bind<std::index_sequence_for<_FreeVars...>>::type;
+    static constexpr size_t next = sizeof...(_FreeVars);
+};
+
+// STRUCT TEMPLATE type_inference
+template <class _ExprTy>
+struct type_inference {
+    using _Free = _Free_variable_context<free_variables_t<_ExprTy>>;
+    using _Result = _Infer<typename _ExprTy::self, typename _Free::type
+        , std_ext::type_list<>, _Free::next>;
+
+    static constexpr bool is_typable = !std::is_same_v<typename _Result::subst, _Infer_failed>;
+
+    using type = typename _Canonical<std::conditional_t<is_typable
+        , _Resolve_t<typename _Result::type, typename _Result::subst>, type_variable<0>>
+        , std_ext::type_list<>>::type; // meaningless unless is_typable
+};
+
+// STRUCT TEMPLATE is_typable
+template <class _ExprTy>
+struct is_typable : std::bool_constant<type_inference<_ExprTy>::is_typable> {};
+
+template <class _ExprTy>
+constexpr bool is_typable_v = is_typable<_ExprTy>::value;
+
+// STRUCT TEMPLATE principal_type
+template <class _ExprTy>
+struct principal_type {
+    static_assert(is_typable_v<_ExprTy>,
+        "principal_type: the term has no simple type (the occurs check failed, as in x x)");
+    using type = typename type_inference<_ExprTy>::type;
+};
+
+template <class _ExprTy>
+using principal_type_t = typename principal_type<typename _ExprTy::self>::type;
+
+// FUNCTION TEMPLATE type_of
+template <class _ExprTy, std::enable_if_t<is_nightly_lambda_v<_ExprTy>, int> = 0>
+constexpr auto type_of(const _ExprTy&) noexcept
+{
+    return principal_type_t<_ExprTy>{};
+}
+
+template <class _ExprTy>
+struct _Identity_reduction {
+    using type = typename _ExprTy::self;
+};
+
+// FUNCTION TEMPLATE checked_evaluate
+template <class _ExprTy, std::enable_if_t<is_nightly_lambda_v<_ExprTy>, int> = 0>
+constexpr auto checked_evaluate(const _ExprTy&) noexcept
+{ // `evaluate` for terms that are certain to terminate; the reduction of a rejected
+  // term is never instantiated
+    static_assert(is_typable_v<typename _ExprTy::self>,
+        "checked_evaluate: the term has no simple type, so its reduction may not terminate");
+
+    return _Public_term_t<typename std::conditional_t<is_typable_v<typename _ExprTy::self>
+        , full_reduction<_ExprTy>, _Identity_reduction<_ExprTy>>::type>{};
+}
+
+// FUNCTION TEMPLATE operator<<
+template <class _Ty, std::enable_if_t<is_simple_type_v<_Ty>, int> = 0>
+std::ostream& operator<<(std::ostream& _Lhs, const _Ty&)
+{
+    return (_Lhs << std_ext::to_string_constant<typename _Ty::_Char_seq_rep>::value);
+}
+
+} // namespace nightly_lambda
+
+#endif // header guard
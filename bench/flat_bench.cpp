@@ -0,0 +1,253 @@
+// flat_bench.cpp - compares the flat term analyses with walks over the arena,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// usage: flat_bench [terms] [symbols] [repetitions]
+//
+// A batch of random terms, with a share of beta and eta redexes, is analysed twice: by one
+// linear walk over the `term_arena` nodes, and by copying the batch into `flat_terms` and
+// running the passes of NightlyFlat.h. Both compute the free variables of every term, the beta
+// and eta redexes and how often each lambda uses its parameter; the totals must agree. The
+// passes are timed one by one, so that the builds below compare the vectorized kernels with
+// the plain loops on the same layout:
+//
+//     g++ -std=c++17 -O2 bench/flat_bench.cpp -o flat_bench
+//     g++ -std=c++17 -O2 -mavx2 bench/flat_bench.cpp -o flat_bench_avx2
+//     g++ -std=c++17 -O2 -DNIGHTLY_LAMBDA_NO_SIMD bench/flat_bench.cpp -o flat_bench_scalar
+
+#include "../NightlyFlat.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+
+namespace {
+
+using namespace nightly_lambda::runtime;
+using _Clock = std::chrono::steady_clock;
+
+class _Generator { // random terms over a fixed set of symbols
+public:
+    _Generator(term_arena& _Arena, unsigned _Symbols) : _Arena(_Arena)
+    {
+        for (unsigned _Idx = 0; _Idx < _Symbols; ++_Idx) {
+            _Syms.push_back(_Arena.intern("v" + std::to_string(_Idx)));
+        }
+    }
+
+    term_ref operator()(unsigned _Depth)
+    {
+        const auto _Roll = static_cast<unsigned>(_Engine() % 100);
+        if (_Depth == 0 || _Roll < 15) {
+            return _Arena.variable(_Pick());
+        }
+
+        if (_Roll < 20) { // [lambda x. (f x)], an eta redex unless x is free in f
+            const symbol _Param = _Pick();
+            return _Arena.lambda(_Param, _Arena.application((*this)(_Depth - 1), _Arena.variable(_Param)));
+        }
+
+        if (_Roll < 30) { // ([lambda x. a] b)
+            const term_ref _Func = _Arena.lambda(_Pick(), (*this)(_Depth - 1));
+            return _Arena.application(_Func, (*this)(_Depth - 1));
+        }
+
+        if (_Roll < 60) {
+            return _Arena.lambda(_Pick(), (*this)(_Depth - 1));
+        }
+
+        const term_ref _Func = (*this)(_Depth - 1);
+        return _Arena.application(_Func, (*this)(_Depth - 1));
+    }
+
+private:
+    symbol _Pick()
+    {
+        return _Syms[_Engine() % _Syms.size()];
+    }
+
+    term_arena& _Arena;
+    std::vector<symbol> _Syms;
+    std::mt19937 _Engine{20200101};
+};
+
+struct _Summary {
+    size_t beta = 0;
+    size_t eta = 0;
+    size_t bound_uses = 0;
+    size_t free_variables = 0;
+
+    bool operator==(const _Summary& _Other) const noexcept
+    {
+        return beta == _Other.beta && eta == _Other.eta && bound_uses == _Other.bound_uses
+            && free_variables == _Other.free_variables;
+    }
+};
+
+class _Arena_pass { // the same analyses in one walk over the arena nodes, linear like the flat
+                    // passes: binders are resolved on the way down, free variables on the way up
+public:
+    _Arena_pass(const term_arena& _Arena, size_t _Symbols)
+        : _Arena(_Arena), _Words((_Symbols + 63) / 64), _Binders(_Symbols) {}
+
+    void operator()(term_ref _Term, _Summary& _Out)
+    {
+        _Sets.clear();
+        _Visit(_Term, _No_symbol, _Out);
+        for (const std::uint64_t _Word : _Sets) {
+            _Out.free_variables += _Popcount(static_cast<unsigned>(_Word))
+                + _Popcount(static_cast<unsigned>(_Word >> 32));
+        }
+    }
+
+private:
+    static constexpr symbol _No_symbol = std::numeric_limits<symbol>::max();
+
+    void _Visit(term_ref _Term, symbol _Eta_param, _Summary& _Out)
+    { // pushes the free variables of _Term; _Eta_param is the parameter of an enclosing
+      // [lambda x. (f x)], which is an eta redex unless x is free in f
+        const term_node& _Node = _Arena[_Term];
+        const size_t _Top = _Sets.size();
+        switch (_Node.kind) {
+        case term_kind::variable:
+            _Out.bound_uses += _Binders[_Node.first] != 0;
+            _Sets.resize(_Top + _Words);
+            _Sets[_Top + _Node.first / 64] |= std::uint64_t{1} << (_Node.first % 64);
+            break;
+        case term_kind::lambda: {
+            const term_node& _Body = _Arena[_Node.second];
+            const bool _Candidate = _Body.kind == term_kind::application
+                && _Arena[_Body.second].kind == term_kind::variable && _Arena[_Body.second].first == _Node.first;
+            ++_Binders[_Node.first];
+            _Visit(_Node.second, _Candidate ? _Node.first : _No_symbol, _Out);
+            --_Binders[_Node.first];
+            _Sets[_Top + _Node.first / 64] &= ~(std::uint64_t{1} << (_Node.first % 64));
+            break;
+        }
+        default:
+            _Out.beta += _Arena[_Node.first].kind == term_kind::lambda;
+            _Visit(_Node.first, _No_symbol, _Out);
+            if (_Eta_param != _No_symbol) {
+                _Out.eta += (_Sets[_Top + _Eta_param / 64] >> (_Eta_param % 64) & 1) == 0;
+            }
+
+            _Visit(_Node.second, _No_symbol, _Out);
+            for (size_t _Word = 0; _Word < _Words; ++_Word) {
+                _Sets[_Top + _Word] |= _Sets[_Top + _Words + _Word];
+            }
+
+            _Sets.resize(_Top + _Words);
+            break;
+        }
+    }
+
+    const term_arena& _Arena;
+    size_t _Words;
+    std::vector<unsigned> _Binders; // the lambdas binding each symbol around the node
+    std::vector<std::uint64_t> _Sets;
+};
+
+template <class _Fn>
+double _Time_per_run(unsigned _Reps, _Fn&& _Run)
+{
+    const auto _Start = _Clock::now();
+    for (unsigned _Idx = 0; _Idx < _Reps; ++_Idx) {
+        _Run();
+    }
+
+    return std::chrono::duration<double, std::micro>(_Clock::now() - _Start).count() / _Reps;
+}
+
+} // unnamed namespace
+
+int main(int _Argc, char** _Argv)
+{
+    const unsigned _Terms = _Argc > 1 ? static_cast<unsigned>(std::strtoul(_Argv[1], nullptr, 10)) : 2000;
+    const unsigned _Symbols = _Argc > 2 ? static_cast<unsigned>(std::strtoul(_Argv[2], nullptr, 10)) : 48;
+    const unsigned _Reps = _Argc > 3 ? static_cast<unsigned>(std::strtoul(_Argv[3], nullptr, 10)) : 20;
+    if (_Terms == 0 || _Symbols == 0 || _Reps == 0) {
+        std::fprintf(stderr, "usage: flat_bench [terms] [symbols] [repetitions]\n");
+        return 2;
+    }
+
+    term_arena _Arena;
+    _Generator _Gen(_Arena, _Symbols);
+    std::vector<term_ref> _Batch;
+    for (unsigned _Idx = 0; _Idx < _Terms; ++_Idx) {
+        _Batch.push_back(_Gen(10));
+    }
+
+    _Summary _Walked;
+    _Arena_pass _Walk(_Arena, _Symbols);
+    const double _Walk_time = _Time_per_run(_Reps, [&] {
+        _Walked = _Summary{};
+        for (const term_ref _Term : _Batch) {
+            _Walk(_Term, _Walked);
+        }
+    });
+
+    flat_terms _Flat;
+    free_variable_sets _Sets;
+    std::vector<std::uint32_t> _Uses_per_lambda;
+    std::vector<unsigned char> _Flags;
+    _Summary _Scanned;
+    double _Pass_times[4] = {}; // the copy, free variables, bound uses and redexes
+    const auto _Timed = [&](double& _Total, auto&& _Pass) {
+        const auto _Start = _Clock::now();
+        _Pass();
+        _Total += std::chrono::duration<double, std::micro>(_Clock::now() - _Start).count();
+    };
+    const double _Flat_time = _Time_per_run(_Reps, [&] {
+        _Timed(_Pass_times[0], [&] {
+            _Flat.clear();
+            for (const term_ref _Term : _Batch) {
+                _Flat.append(_Arena, _Term);
+            }
+        });
+        _Timed(_Pass_times[1], [&] { compute_free_variables(_Flat, _Sets); });
+        _Timed(_Pass_times[2], [&] { count_bound_occurrences(_Flat, _Uses_per_lambda); });
+        redex_counts _Redexes;
+        _Timed(_Pass_times[3], [&] { _Redexes = scan_redexes(_Flat, _Sets, _Flags); });
+        _Scanned = _Summary{};
+        _Scanned.beta = _Redexes.beta;
+        _Scanned.eta = _Redexes.eta;
+        for (const std::uint32_t _Count : _Uses_per_lambda) {
+            _Scanned.bound_uses += _Count;
+        }
+
+        for (const flat_ref _Root : _Flat.roots()) {
+            for (symbol _Sym = 0; _Sym < _Flat.symbol_limit(); ++_Sym) {
+                _Scanned.free_variables += _Sets.contains(_Root, _Sym);
+            }
+        }
+    });
+
+    size_t _Occurrences = 0;
+    const double _Count_time = _Time_per_run(_Reps, [&] { // over the whole store once per symbol
+        _Occurrences = 0;
+        for (symbol _Sym = 0; _Sym < _Flat.symbol_limit(); ++_Sym) {
+            _Occurrences += count_occurrences(_Flat, _Sym);
+        }
+    });
+
+    size_t _Variables = 0;
+    for (flat_ref _Idx = 0; _Idx < _Flat.size(); ++_Idx) {
+        _Variables += _Flat.kind(_Idx) == term_kind::variable;
+    }
+
+    const bool _Agree = _Walked == _Scanned && _Occurrences == _Variables;
+    std::printf("%u terms, %zu nodes, %u symbols, %s\n", _Terms, _Flat.size(), _Symbols, flat_simd_level());
+    std::printf("%-22s %12s %8s %8s %12s %12s\n", "", "time (us)", "beta", "eta", "bound uses", "free vars");
+    std::printf("%-22s %12.1f %8zu %8zu %12zu %12zu\n", "arena pass", _Walk_time
+        , _Walked.beta, _Walked.eta, _Walked.bound_uses, _Walked.free_variables);
+    std::printf("%-22s %12.1f %8zu %8zu %12zu %12zu%s\n", "flat passes", _Flat_time
+        , _Scanned.beta, _Scanned.eta, _Scanned.bound_uses, _Scanned.free_variables, _Agree ? "" : "  MISMATCH");
+    std::printf("  copy %.1f, free variables %.1f, bound uses %.1f, redexes %.1f us;"
+        " count_occurrences of every symbol %.1f us\n", _Pass_times[0] / _Reps, _Pass_times[1] / _Reps
+        , _Pass_times[2] / _Reps, _Pass_times[3] / _Reps, _Count_time);
+    std::printf("speedup %.2fx, %.2fx without the copy\n", _Walk_time / _Flat_time
+        , _Walk_time / (_Flat_time - _Pass_times[0] / _Reps));
+    return _Agree ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+// heap_bench.cpp - compares the garbage-collected heap engine with the bump arena engine,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// usage: heap_bench [exponent] [nursery cells] [promotion age]
+//
+// The long run applies [lambda k. [lambda a. (k a)]] 2^exponent times to the identity, which
+// takes millions of steps but keeps only a handful of values alive at any time; its normal
+// form is [lambda x. x]. `nbe_engine` keeps every value until the term is done, `heap_engine`
+// collects them as it goes: the table shows the memory each one holds and the pauses of the
+// collector. The live run builds the numeral 2^exponent by applying two to itself that many
+// times, so that millions of cells and a stack of millions of roots stay alive until its read
+// back ends; its pauses show that neither kind of collection grows with them. The Church
+// numeral suite of nbe_bench.cpp then checks both engines agree.
+//
+//     g++ -std=c++17 -O2 bench/heap_bench.cpp -o heap_bench && ./heap_bench 22
+
+#include "../NightlyHeap.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+using namespace nightly_lambda::runtime;
+using _Clock = std::chrono::steady_clock;
+
+std::string _Church(unsigned _N)
+{
+    std::string _Body = "x";
+    for (unsigned _Idx = 0; _Idx < _N; ++_Idx) {
+        _Body = "(f " + _Body + ")";
+    }
+
+    return "[lambda f. [lambda x. " + _Body + "]]";
+}
+
+const std::string _Succ = "[lambda n. [lambda f. [lambda x. (f ((n f) x))]]]";
+const std::string _Add = "[lambda m. [lambda n. [lambda f. [lambda x. ((m f) ((n f) x))]]]]";
+const std::string _Mul = "[lambda m. [lambda n. [lambda f. (m (n f))]]]";
+const std::string _Exp = "[lambda m. [lambda n. (n m)]]";
+const std::string _Pred = "[lambda n. [lambda f. [lambda x. (((n [lambda g. [lambda h. (h (g f))]])"
+    " [lambda u. x]) [lambda u. u])]]]";
+
+std::string _Apply(const std::string& _Func, const std::string& _Arg)
+{
+    return "(" + _Func + " " + _Arg + ")";
+}
+
+struct _Case {
+    const char* name;
+    std::string text;
+};
+
+std::vector<_Case> _Suite()
+{
+    return {
+        {"succ 100", _Apply(_Succ, _Church(100))},
+        {"add 200 300", _Apply(_Apply(_Add, _Church(200)), _Church(300))},
+        {"mul 100 100", _Apply(_Apply(_Mul, _Church(100)), _Church(100))},
+        {"exp 3 7", _Apply(_Apply(_Exp, _Church(3)), _Church(7))},
+        {"pred (mul 20 20)", _Apply(_Pred, _Apply(_Apply(_Mul, _Church(20)), _Church(20)))},
+        {"free variables", "[lambda y. (((" + _Apply(_Exp, _Church(2)) + " " + _Church(5) + ") y) z)]"},
+        {"shadowing", "([lambda x. [lambda y. [lambda y. (x y)]]] [lambda z. y])"},
+    };
+}
+
+double _Ms_since(_Clock::time_point _Start)
+{
+    return std::chrono::duration<double, std::milli>(_Clock::now() - _Start).count();
+}
+
+bool _Compare(const std::string& _Title, const std::string& _Text, const char* _Expected
+    , const heap_options& _Options)
+{ // both engines on `_Text`, which must reach the same normal form in the same steps, and
+  // `_Expected` unless null
+    term_arena _Nbe_arena;
+    nbe_engine _Nbe;
+    reduction_stats _Nbe_stats;
+    auto _Start = _Clock::now();
+    const term_ref _Nbe_result = _Nbe.normalize(_Nbe_arena, parse_term(_Nbe_arena, _Text)
+        , reduction_options{}, _Nbe_stats);
+    const double _Nbe_time = _Ms_since(_Start);
+
+    term_arena _Heap_arena;
+    heap_engine _Engine(_Options);
+    reduction_stats _Heap_stats;
+    _Start = _Clock::now();
+    const term_ref _Heap_result = _Engine.normalize(_Heap_arena, parse_term(_Heap_arena, _Text)
+        , reduction_options{}, _Heap_stats);
+    const double _Heap_time = _Ms_since(_Start);
+
+    bool _Ok = alpha_equivalent(_Nbe_arena, _Nbe_result, _Heap_arena, _Heap_result)
+        && _Nbe_stats.steps == _Heap_stats.steps;
+    if (_Expected) {
+        term_arena _Expected_arena;
+        _Ok = _Ok && alpha_equivalent(_Heap_arena, _Heap_result, _Expected_arena
+            , parse_term(_Expected_arena, _Expected));
+    }
+
+    const heap_stats& _Gc = _Engine.heap().stats();
+    std::printf("%s, %llu steps, nursery %zu cells, promotion age %u\n", _Title.c_str()
+        , static_cast<unsigned long long>(_Heap_stats.steps), _Options.nursery_cells, _Options.promotion_age);
+    std::printf("%-8s %10s %12s %14s\n", "", "time (ms)", "memory (KB)", "steps/s (M)");
+    std::printf("%-8s %10.1f %12zu %14.1f\n", "nbe", _Nbe_time, _Nbe.arena_bytes() / 1024
+        , static_cast<double>(_Nbe_stats.steps) / _Nbe_time / 1000);
+    std::printf("%-8s %10.1f %12zu %14.1f%s\n", "heap", _Heap_time, _Gc.peak_reserved_bytes / 1024
+        , static_cast<double>(_Heap_stats.steps) / _Heap_time / 1000, _Ok ? "" : "  MISMATCH");
+    std::printf("%llu minor, %llu major collections in %llu steps, %llu cells copied, %llu promoted"
+        " and %llu freed of %llu allocated\n", static_cast<unsigned long long>(_Gc.minor_collections)
+        , static_cast<unsigned long long>(_Gc.major_collections), static_cast<unsigned long long>(_Gc.major_steps)
+        , static_cast<unsigned long long>(_Gc.copied), static_cast<unsigned long long>(_Gc.promoted)
+        , static_cast<unsigned long long>(_Gc.freed), static_cast<unsigned long long>(_Gc.allocated));
+    std::printf("pauses: %.1f%% of the time, longest minor %.1f us, longest major %.1f us, %llu over 1 ms\n\n"
+        , static_cast<double>(_Gc.pause_ns) / 1e4 / _Heap_time, static_cast<double>(_Gc.max_minor_pause_ns) / 1e3
+        , static_cast<double>(_Gc.max_major_pause_ns) / 1e3, static_cast<unsigned long long>(_Gc.slow_pauses));
+    return _Ok;
+}
+
+} // unnamed namespace
+
+int main(int _Argc, char** _Argv)
+{
+    const unsigned _Exponent = _Argc > 1 ? static_cast<unsigned>(std::strtoul(_Argv[1], nullptr, 10)) : 20;
+    heap_options _Options;
+    if (_Argc > 2) {
+        _Options.nursery_cells = std::strtoul(_Argv[2], nullptr, 10);
+    }
+
+    if (_Argc > 3) {
+        _Options.promotion_age = static_cast<unsigned>(std::strtoul(_Argv[3], nullptr, 10));
+    }
+
+    if (_Exponent == 0 || _Exponent > 30 || _Options.nursery_cells == 0 || _Options.promotion_age == 0) {
+        std::fprintf(stderr, "usage: heap_bench [exponent] [nursery cells] [promotion age]\n");
+        return 2;
+    }
+
+    const std::string _Long_run = "[lambda x. ((((" + _Apply(_Exp, _Church(2)) + " " + _Church(_Exponent)
+        + ") [lambda k. [lambda a. (k a)]]) [lambda a. a]) x)]";
+
+    const std::string _Live_run = _Apply(_Church(_Exponent), _Church(2));
+
+    const std::string _Title = "2^" + std::to_string(_Exponent);
+    bool _Ok = _Compare(_Title + " applications", _Long_run, "[lambda x. x]", _Options);
+    _Ok = _Compare(_Title + " by doubling", _Live_run, nullptr, _Options) && _Ok;
+
+    nbe_engine _Nbe;
+    heap_engine _Suite_engine(_Options);
+    for (const _Case& _Item : _Suite()) {
+        term_arena _Arena;
+        reduction_stats _Expected_stats;
+        reduction_stats _Stats;
+        const term_ref _Term = parse_term(_Arena, _Item.text);
+        const term_ref _By_nbe = _Nbe.normalize(_Arena, _Term, reduction_options{}, _Expected_stats);
+        const term_ref _By_heap = _Suite_engine.normalize(_Arena, _Term, reduction_options{}, _Stats);
+        const bool _Agree = alpha_equivalent(_Arena, _By_nbe, _Arena, _By_heap)
+            && _Expected_stats.steps == _Stats.steps;
+        _Ok = _Ok && _Agree;
+        std::printf("%-20s %12llu steps%s\n", _Item.name, static_cast<unsigned long long>(_Stats.steps)
+            , _Agree ? "" : "  MISMATCH");
+    }
+
+    return _Ok ? 0 : 1;
+}
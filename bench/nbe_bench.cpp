@@ -0,0 +1,123 @@
+// nbe_bench.cpp - compares normalization by evaluation with the substitution reducer,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// usage: nbe_bench [repetitions]
+//
+// Every case of the Church numeral suite is normalized by `normalize` (normal order) and by
+// `nbe_engine`; the normal forms must be alpha-equivalent. Each side reuses its arena or
+// engine across repetitions, the way a batch worker would.
+
+#include "../NightlyNbe.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+using namespace nightly_lambda::runtime;
+using _Clock = std::chrono::steady_clock;
+
+std::string _Church(unsigned _N)
+{
+    std::string _Body = "x";
+    for (unsigned _Idx = 0; _Idx < _N; ++_Idx) {
+        _Body = "(f " + _Body + ")";
+    }
+
+    return "[lambda f. [lambda x. " + _Body + "]]";
+}
+
+const std::string _Succ = "[lambda n. [lambda f. [lambda x. (f ((n f) x))]]]";
+const std::string _Add = "[lambda m. [lambda n. [lambda f. [lambda x. ((m f) ((n f) x))]]]]";
+const std::string _Mul = "[lambda m. [lambda n. [lambda f. (m (n f))]]]";
+const std::string _Exp = "[lambda m. [lambda n. (n m)]]";
+const std::string _Pred = "[lambda n. [lambda f. [lambda x. (((n [lambda g. [lambda h. (h (g f))]])"
+    " [lambda u. x]) [lambda u. u])]]]";
+
+std::string _Apply(const std::string& _Func, const std::string& _Arg)
+{
+    return "(" + _Func + " " + _Arg + ")";
+}
+
+struct _Case {
+    const char* name;
+    std::string text;
+    unsigned expected;
+};
+
+std::vector<_Case> _Suite()
+{
+    return {
+        {"succ 100", _Apply(_Succ, _Church(100)), 101},
+        {"add 200 300", _Apply(_Apply(_Add, _Church(200)), _Church(300)), 500},
+        {"mul 30 30", _Apply(_Apply(_Mul, _Church(30)), _Church(30)), 900},
+        {"mul 100 100", _Apply(_Apply(_Mul, _Church(100)), _Church(100)), 10000},
+        {"exp 2 10", _Apply(_Apply(_Exp, _Church(2)), _Church(10)), 1024},
+        {"exp 3 7", _Apply(_Apply(_Exp, _Church(3)), _Church(7)), 2187},
+        {"pred 200", _Apply(_Pred, _Church(200)), 199},
+        {"pred (mul 20 20)", _Apply(_Pred, _Apply(_Apply(_Mul, _Church(20)), _Church(20))), 399},
+    };
+}
+
+template <class _Fn>
+double _Time_per_run(unsigned _Reps, _Fn&& _Run)
+{
+    const auto _Start = _Clock::now();
+    for (unsigned _Idx = 0; _Idx < _Reps; ++_Idx) {
+        _Run();
+    }
+
+    return std::chrono::duration<double, std::micro>(_Clock::now() - _Start).count() / _Reps;
+}
+
+} // unnamed namespace
+
+int main(int _Argc, char** _Argv)
+{
+    const unsigned _Reps = _Argc > 1 ? static_cast<unsigned>(std::strtoul(_Argv[1], nullptr, 10)) : 20;
+    if (_Reps == 0) {
+        std::fprintf(stderr, "usage: nbe_bench [repetitions]\n");
+        return 2;
+    }
+
+    std::printf("%-20s %14s %14s %9s %12s %12s\n"
+        , "case", "subst (us)", "nbe (us)", "speedup", "subst steps", "nbe steps");
+
+    bool _Ok = true;
+    for (const _Case& _Item : _Suite()) {
+        term_arena _Subst_arena;
+        reduction_stats _Subst_stats;
+        term_ref _Subst_result = 0;
+        const double _Subst_time = _Time_per_run(_Reps, [&] {
+            _Subst_arena.clear();
+            _Subst_stats = reduction_stats{};
+            _Subst_result = normalize(_Subst_arena, parse_term(_Subst_arena, _Item.text)
+                , reduction_options{}, _Subst_stats);
+        });
+
+        term_arena _Nbe_arena;
+        nbe_engine _Engine;
+        reduction_stats _Nbe_stats;
+        term_ref _Nbe_result = 0;
+        const double _Nbe_time = _Time_per_run(_Reps, [&] {
+            _Nbe_arena.clear();
+            _Nbe_stats = reduction_stats{};
+            _Nbe_result = _Engine.normalize(_Nbe_arena, parse_term(_Nbe_arena, _Item.text)
+                , reduction_options{}, _Nbe_stats);
+        });
+
+        term_arena _Expected_arena;
+        const term_ref _Expected = parse_term(_Expected_arena, _Church(_Item.expected));
+        const bool _Agree = alpha_equivalent(_Subst_arena, _Subst_result, _Expected_arena, _Expected)
+            && alpha_equivalent(_Nbe_arena, _Nbe_result, _Expected_arena, _Expected);
+        _Ok = _Ok && _Agree;
+
+        std::printf("%-20s %14.1f %14.1f %8.2fx %12llu %12llu%s\n", _Item.name, _Subst_time, _Nbe_time
+            , _Subst_time / _Nbe_time, static_cast<unsigned long long>(_Subst_stats.steps)
+            , static_cast<unsigned long long>(_Nbe_stats.steps), _Agree ? "" : "  MISMATCH");
+    }
+
+    return _Ok ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// static_tests.cpp - compile-time checks of the term transformations, reductions and types,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// Every check is a static_assert, so the unit passes by compiling. `make check` builds it in
+// C++17 and C++20, each with and without NIGHTLY_LAMBDA_INTERN_TERMS, so that the interned
+// terms are held to the same results:
+//
+//     g++ -std=c++17 -Wall -Wextra tests/static_tests.cpp -o static_tests
+//     g++ -std=c++17 -Wall -Wextra -DNIGHTLY_LAMBDA_INTERN_TERMS tests/static_tests.cpp -o static_tests
+//
+// The terms below avoid beta and eta redexes where the check is not about reduction, because
+// `lambda` and `fix` evaluate their body. Redexes that must not be reduced up front are spelled
+// as node types.
+
+#include "../NightlyNative.h"
+#include "../NightlyPrelude.h"
+#include "../NightlyTypes.h"
+
+namespace {
+
+using namespace nightly_lambda;
+using namespace nightly_lambda::names;
+using namespace nightly_lambda::prelude;
+
+template <class _Left, class _Right>
+constexpr bool _Same(const _Left&, const _Right&) noexcept
+{ // the same term, whichever form each one comes in
+    return std::is_same_v<typename _Left::self, typename _Right::self>;
+}
+
+constexpr shadowed<variable_node<23>> _Xp; // x', which can only be an argument: its calls would
+                                          // be those of x
+constexpr shadowed<variable_node<24>> _Yp; // y'
+
+template <class _ExprTy, class... _Substs>
+constexpr closure_node<typename _ExprTy::self, std_ext::type_list<
+    subst<typename _Substs::prim::self, typename _Substs::sec::self>...>> _Closure(
+    const _ExprTy&, const _Substs&...) noexcept
+{ // with structural children, as the library builds its nodes
+    return {};
+}
+
+// rename and unshadow under lambda and fix
+static_assert(_Same(lambda(x, x(y)).rename(x, z), lambda(z, z(y))));
+static_assert(_Same(fix(f, lambda(x, f(x)(x))).rename(f, g), fix(g, lambda(x, g(x)(x)))));
+static_assert(_Same(fix(f, lambda(x, f(x)(x))).rename(x, z), fix(f, lambda(z, f(z)(z)))));
+static_assert(_Same(lambda(_Xp, _Xp).unshadow(y), lambda(y, y)));
+static_assert(_Same(lambda(y, lambda(_Xp, y(_Xp)(y))).unshadow(z), lambda(y, lambda(z, y(z)(y)))));
+static_assert(_Same(fix(_Xp, lambda(y, y(_Xp)(y))).unshadow(z), fix(z, lambda(y, y(z)(y)))));
+static_assert(_Same(lambda(_Xp, lambda(_Yp, w(_Yp)(_Xp))).unshadow(u, v), lambda(u, lambda(v, w(v)(u)))));
+
+// rename and unshadow under closures, in the body first and then in the pending substitutions
+static_assert(_Same(_Closure(lambda(x, x(y)), y <= lambda(x, x(x))).rename(x, z)
+    , _Closure(lambda(z, z(y)), y <= lambda(x, x(x)))));
+static_assert(_Same(_Closure(y(w), y <= lambda(x, x(x))).rename(x, z)
+    , _Closure(y(w), y <= lambda(z, z(z)))));
+static_assert(_Same(_Closure(lambda(_Xp, w(_Xp)(y)), y <= lambda(_Yp, w(_Yp)(_Yp))).unshadow(u, v)
+    , _Closure(lambda(u, w(u)(y)), y <= lambda(v, w(v)(v)))));
+
+// types of fix and closures
+template <class _ExprTy, class _Ty>
+constexpr bool _Has_type = std::is_same_v<principal_type_t<_ExprTy>, _Ty>;
+
+using _Ta = type_variable<0>;
+using _Tb = type_variable<1>;
+
+static_assert(_Has_type<decltype(fix(f, lambda(x, f(f(x))))), arrow_type<_Ta, _Ta>>);
+static_assert(_Has_type<decltype(fix(f, lambda(x, lambda(y, f(y)(x)))))
+    , arrow_type<_Ta, arrow_type<_Ta, _Tb>>>);
+static_assert(_Has_type<decltype(fix(f, f)), _Ta>);
+static_assert(!is_typable_v<decltype(fix(f, lambda(x, f(x)(x))))>); // f x x needs b = a -> b
+static_assert(_Has_type<decltype(_Closure(lambda(x, y(x)), y <= lambda(z, z))), arrow_type<_Ta, _Ta>>);
+static_assert(!is_typable_v<decltype(_Closure(y(y), y <= lambda(z, z)))>); // as ([lambda y. (y y)] b)
+
+// weak head and lazy reduction leave their substitutions pending in closures
+using _X = variable_node<23>;
+using _Y = variable_node<24>;
+using _Z = variable_node<25>;
+using _Dup = lambda_node<_X, application_node<_X, _X>>; // [lambda x. (x x)]
+using _Omega = application_node<_Dup, _Dup>;             // reduces to itself forever
+using _K = lambda_node<_X, lambda_node<_Y, _X>>;
+
+static_assert(_Same(weak_head_evaluate(application_node<lambda_node<_X
+    , lambda_node<_Y, application_node<_Y, _X>>>, _Z>{})
+    , lambda_node<_Y, decltype(_Closure(y(x), x <= z))>{})); // stops at the lambda
+static_assert(_Same(weak_head_evaluate(application_node<application_node<_K, _Dup>, _Omega>{}), _Dup{}));
+static_assert(_Same(lazy_evaluate(application_node<application_node<_K, _Z>, _Omega>{}), z));
+static_assert(_Same(lazy_evaluate(_Closure(lambda(y, x(y)(y)), x <= lambda(u, v, v))), lambda(y, y)));
+
+// fix is unrolled only where the lazy reduction applies it
+constexpr auto _Fact = fix(r, lambda(n, church_iszero(n)(church_1)(church_mul(n)(r(church_pred(n))))));
+constexpr auto _Flip = fix(f, lambda(x, lambda(y, f(y)(x))));
+
+static_assert(is_fix_v<typename decltype(_Fact(church_3))::self::prim::self>); // left alone by evaluate
+static_assert(_Same(lazy_evaluate(_Fact(church_3)), church_6));
+static_assert(_Same(lazy_evaluate(_Fact(church_0)), church_1));
+static_assert(_Same(weak_head_evaluate(_Flip(z)), lambda_node<_Y // unrolled once
+    , decltype(_Closure(f(y)(x), f <= _Flip, x <= z))>{}));
+
+// simple types
+static_assert(_Has_type<decltype(lambda(x, x)), arrow_type<_Ta, _Ta>>);
+static_assert(_Has_type<decltype(church_true), arrow_type<_Ta, arrow_type<_Tb, _Ta>>>);
+static_assert(_Has_type<decltype(lambda(x, y, z, x(z)(y(z))))
+    , arrow_type<arrow_type<_Ta, arrow_type<_Tb, type_variable<2>>>
+        , arrow_type<arrow_type<_Ta, _Tb>, arrow_type<_Ta, type_variable<2>>>>>);
+static_assert(_Has_type<decltype(y(x)), _Ta>); // free variables get types of their own
+static_assert(!is_typable_v<_Dup>);
+static_assert(!is_typable_v<_Omega>);
+static_assert(_Same(checked_evaluate(application_node<lambda_node<_X, _X>, _Z>{}), z));
+
+// lowering: false is the numeral zero
+static_assert(to_bool(lower(church_true)) && !to_bool(lower(church_false)));
+static_assert(to_size_t(lower(church_add)(church<2>())(church<3>())) == 5);
+
+#ifdef NIGHTLY_LAMBDA_INTERN_TERMS
+// interned terms name the same structure as the eager reduction of their expression
+static_assert(is_interned_v<decltype(lambda(x, x))>);
+static_assert(is_interned_v<decltype(evaluate(application_node<lambda_node<_X, _X>, _Z>{}))>);
+static_assert(is_interned_v<decltype(checked_evaluate(application_node<lambda_node<_X, _X>, _Z>{}))>);
+static_assert(is_interned_v<decltype(lazy_evaluate(_Fact(church_3)))>);
+static_assert(std::is_same_v<decltype(lambda(y, y)), decltype(evaluate(application_node<_K
+    , lambda_node<_Y, _Y>>{})(z))>); // one ID per structure, however it was reached
+static_assert(std::is_same_v<decltype(church_mul(church_2)(church_3))::self
+    , full_reduction_t<application_node<application_node<decltype(church_mul)::self
+        , decltype(church_2)::self>, decltype(church_3)::self>>>);
+static_assert(std::is_same_v<intern_t<typename decltype(church_6)::self>, intern_t<decltype(church_6)>>);
+#else // NIGHTLY_LAMBDA_INTERN_TERMS
+static_assert(!is_interned_v<decltype(lambda(x, x))>);
+static_assert(std::is_same_v<decltype(lambda(x, x)), lambda_node<_X, _X>>);
+#endif // NIGHTLY_LAMBDA_INTERN_TERMS
+
+} // unnamed namespace
+
+int main() {}
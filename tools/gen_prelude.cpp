@@ -0,0 +1,326 @@
+// gen_prelude.cpp - generates the prelude of pre-normalized standard terms,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// usage: gen_prelude [options]
+//
+//   --numerals=N                         Church numerals 0 to N (default 16)
+//   --header=FILE                        the header to write (default NightlyPrelude.h)
+//   --module=FILE                        the module interface to write
+//                                        (default NightlyPrelude.cppm)
+//
+// Every standard term is evaluated here, once, and written out as the spelling of its
+// normal form, `lambda_node<variable_node<23>, variable_node<23>>` for [lambda x. x], so that
+// a translation unit including the header names the terms without instantiating any of the
+// reductions that produced them. The numerals are spelled directly, the way `lambda` builds
+// them: one is eta reduced to [lambda f. f]. Compiling the header with NIGHTLY_PRELUDE_VERIFY
+// checks every spelling against the library.
+//
+// Regenerate and build the prelude once per build, as a module where the compiler has them and
+// as a header unit or a precompiled header otherwise:
+//
+//     g++ -std=c++17 tools/gen_prelude.cpp -o gen_prelude && ./gen_prelude --numerals=32
+//     g++ -std=c++20 -fmodules-ts -c -x c++ NightlyPrelude.cppm -o NightlyPrelude.o
+//     g++ -std=c++20 -fmodules-ts -x c++-header NightlyPrelude.h
+//     g++ -std=c++17 -x c++-header NightlyPrelude.h -o NightlyPrelude.h.gch
+
+#include "../NightlyLambda.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace nightly_lambda;
+using namespace nightly_lambda::names;
+
+template <class _ExprTy>
+struct _Spelling { // the C++ type of a normal form
+    static_assert(is_variable_v<_ExprTy>, "a prelude term contains an unexpected node");
+
+    static void append(std::string& _Out)
+    {
+        _Out += "variable_node<" + std::to_string(_ExprTy::number) + ">";
+    }
+};
+
+template <class _VarTy, class _ExprTy>
+struct _Spelling<lambda_node<_VarTy, _ExprTy>> {
+    static void append(std::string& _Out)
+    {
+        _Out += "lambda_node<";
+        _Spelling<typename _VarTy::self>::append(_Out);
+        _Out += ", ";
+        _Spelling<typename _ExprTy::self>::append(_Out);
+        _Out += ">";
+    }
+};
+
+template <class _FuncTy, class _ArgTy>
+struct _Spelling<application_node<_FuncTy, _ArgTy>> {
+    static void append(std::string& _Out)
+    {
+        _Out += "application_node<";
+        _Spelling<typename _FuncTy::self>::append(_Out);
+        _Out += ", ";
+        _Spelling<typename _ArgTy::self>::append(_Out);
+        _Out += ">";
+    }
+};
+
+struct _Term {
+    std::string name;
+    std::string source;   // the expression the library evaluates to the same type
+    std::string spelling; // the type of the normal form
+    std::string printed;  // as `operator<<` prints it
+};
+
+template <class _ExprTy>
+_Term _Make_term(const char* _Name, const char* _Source, const _ExprTy& _Expr)
+{
+    const auto _Normal = evaluate(_Expr);
+    _Term _Result{_Name, _Source, {}, {}};
+    _Spelling<typename decltype(_Normal)::self>::append(_Result.spelling);
+    std::ostringstream _Printed;
+    _Printed << _Normal;
+    _Result.printed = _Printed.str();
+    return _Result;
+}
+
+#define _PRELUDE_TERM(_Name, ...) _Make_term(#_Name, #__VA_ARGS__, __VA_ARGS__)
+
+std::vector<_Term> _Standard_terms()
+{ // later terms may refer to earlier ones by name
+    constexpr auto church_true = lambda(a, b, a);
+    constexpr auto church_false = lambda(a, b, b);
+    return {
+        _PRELUDE_TERM(i_combinator, lambda(x, x)),
+        _PRELUDE_TERM(k_combinator, lambda(x, y, x)),
+        _PRELUDE_TERM(s_combinator, lambda(x, y, z, x(z)(y(z)))),
+        _PRELUDE_TERM(b_combinator, lambda(f, g, x, f(g(x)))),
+        _PRELUDE_TERM(c_combinator, lambda(f, x, y, f(y)(x))),
+        _PRELUDE_TERM(w_combinator, lambda(f, x, f(x)(x))),
+        _PRELUDE_TERM(omega, lambda(x, x(x))),
+        _PRELUDE_TERM(church_true, lambda(a, b, a)),
+        _PRELUDE_TERM(church_false, lambda(a, b, b)),
+        _PRELUDE_TERM(church_not, lambda(p, a, b, p(b)(a))),
+        _PRELUDE_TERM(church_and, lambda(p, q, p(q)(p))),
+        _PRELUDE_TERM(church_or, lambda(p, q, p(p)(q))),
+        _PRELUDE_TERM(church_succ, lambda(n, f, x, f(n(f)(x)))),
+        _PRELUDE_TERM(church_pred, lambda(n, f, x, n(lambda(g, h, h(g(f))))(lambda(u, x))(lambda(u, u)))),
+        _PRELUDE_TERM(church_add, lambda(m, n, f, x, m(f)(n(f)(x)))),
+        _PRELUDE_TERM(church_mul, lambda(m, n, f, m(n(f)))),
+        _PRELUDE_TERM(church_exp, lambda(m, n, n(m))),
+        _PRELUDE_TERM(church_iszero, lambda(n, n(lambda(x, church_false))(church_true))),
+        _PRELUDE_TERM(church_pair, lambda(a, b, f, f(a)(b))),
+        _PRELUDE_TERM(church_first, lambda(p, p(church_true))),
+        _PRELUDE_TERM(church_second, lambda(p, p(church_false))),
+    };
+}
+
+#undef _PRELUDE_TERM
+
+_Term _Numeral(unsigned long long _Count)
+{ // [lambda f. [lambda x. (f ... (f x))]], spelled without evaluating it
+    const std::string _Fname = "variable_node<" + std::to_string(f.number) + ">";
+    const std::string _Xname = "variable_node<" + std::to_string(x.number) + ">";
+    _Term _Result{"church_" + std::to_string(_Count), {}, {}, {}};
+    if (_Count == 1) { // [lambda x. (f x)] is eta reduced
+        _Result.source = "lambda(f, x, f(x))";
+        _Result.spelling = "lambda_node<" + _Fname + ", " + _Fname + ">";
+        _Result.printed = "[lambda f. f]";
+        return _Result;
+    }
+
+    std::string _Source = "x";
+    std::string _Spelled = _Xname;
+    std::string _Printed = "x";
+    for (unsigned long long _Idx = 0; _Idx < _Count; ++_Idx) {
+        _Source = "f(" + _Source + ")";
+        _Spelled = "application_node<" + _Fname + ", " + _Spelled + ">";
+        _Printed = "(f " + _Printed + ")";
+    }
+
+    _Result.source = "lambda(f, x, " + _Source + ")";
+    _Result.spelling = "lambda_node<" + _Fname + ", lambda_node<" + _Xname + ", " + _Spelled + ">>";
+    _Result.printed = "[lambda f. [lambda x. " + _Printed + "]]";
+    return _Result;
+}
+
+void _Write_term(std::ostream& _Out, const _Term& _Item)
+{
+    _Out << "// " << _Item.printed << "\n"
+         << "using " << _Item.name << "_t = " << _Item.spelling << ";\n"
+         << "inline constexpr _Public_term_t<" << _Item.name << "_t> " << _Item.name << "{};\n\n";
+}
+
+void _Write_header(std::ostream& _Out, const std::vector<_Term>& _Terms
+    , const std::vector<_Term>& _Numerals)
+{
+    _Out << "// NightlyPrelude.h - implements pre-normalized standard terms,\n"
+            "//\n"
+            "// Copyright (c) 2020 Yuan Ruihong all rights reserved.\n"
+            "\n"
+            "// Generated by tools/gen_prelude.cpp --numerals=" << _Numerals.size() - 1 << ", do not edit.\n"
+            "//\n"
+            "// Every term is spelled as the type of its normal form, so naming one costs no reduction.\n"
+            "// `numeral_t<N>` is church_N for N up to `numeral_limit`. Define NIGHTLY_PRELUDE_VERIFY to\n"
+            "// check the spellings against the library; that instantiates everything this header saves.\n"
+            "\n"
+            "#pragma once\n"
+            "#ifndef YUAN_NIGHTLY_PRELUDE\n"
+            "#define YUAN_NIGHTLY_PRELUDE\n"
+            "\n"
+            "#include \"NightlyLambda.h\"\n"
+            "\n"
+            "namespace nightly_lambda {\n"
+            "namespace prelude {\n"
+            "\n";
+    for (const _Term& _Item : _Terms) {
+        _Write_term(_Out, _Item);
+    }
+
+    for (const _Term& _Item : _Numerals) {
+        _Write_term(_Out, _Item);
+    }
+
+    _Out << "inline constexpr size_t numeral_limit = " << _Numerals.size() - 1 << ";\n"
+            "\n"
+            "template <size_t _Nx>\n"
+            "struct _Numeral {\n"
+            "    static_assert(_Nx <= numeral_limit, \"regenerate the prelude with a larger --numerals\");\n"
+            "};\n"
+            "\n";
+    for (size_t _Idx = 0; _Idx < _Numerals.size(); ++_Idx) {
+        _Out << "template <>\nstruct _Numeral<" << _Idx << "> {\n"
+             << "    using type = " << _Numerals[_Idx].name << "_t;\n};\n\n";
+    }
+
+    _Out << "// ALIAS TEMPLATE numeral_t\n"
+            "template <size_t _Nx>\n"
+            "using numeral_t = typename _Numeral<_Nx>::type;\n"
+            "\n"
+            "#ifdef NIGHTLY_PRELUDE_VERIFY\n"
+            "namespace _Verify {\n"
+            "using namespace names;\n"
+            "\n";
+    const auto _Write_check = [&_Out](const _Term& _Item) {
+        _Out << "static_assert(std::is_same_v<" << _Item.name << "_t\n"
+             << "    , typename decltype(evaluate(" << _Item.source << "))::self>, \"" << _Item.name << "\");\n";
+    };
+    for (const _Term& _Item : _Terms) {
+        _Write_check(_Item);
+    }
+
+    for (const _Term& _Item : _Numerals) {
+        _Write_check(_Item);
+    }
+
+    _Out << "} // namespace _Verify\n"
+            "#endif // NIGHTLY_PRELUDE_VERIFY\n"
+            "\n"
+            "} // namespace prelude\n"
+            "} // namespace nightly_lambda\n"
+            "\n"
+            "#endif // header guard\n";
+}
+
+void _Write_module(std::ostream& _Out, size_t _Limit)
+{
+    _Out << "// NightlyPrelude.cppm - implements the prelude as a C++20 module,\n"
+            "//\n"
+            "// Copyright (c) 2020 Yuan Ruihong all rights reserved.\n"
+            "\n"
+            "// Generated by tools/gen_prelude.cpp --numerals=" << _Limit << ", do not edit.\n"
+            "//\n"
+            "// `import nightly_lambda.prelude;` provides the library and the prelude. The interface is\n"
+            "// compiled once per build, and importers read the terms from its binary module interface\n"
+            "// instead of parsing and instantiating NightlyLambda.h again. The standard headers the\n"
+            "// library includes go to the global module fragment, so that they stay out of the module.\n"
+            "\n"
+            "module;\n"
+            "\n"
+            "#include <cstddef>\n"
+            "#include <cstdint>\n"
+            "#include <iostream>\n"
+            "#include <tuple>\n"
+            "#include <type_traits>\n"
+            "\n"
+            "export module nightly_lambda.prelude;\n"
+            "\n"
+            "export {\n"
+            "#include \"NightlyPrelude.h\"\n"
+            "}\n";
+}
+
+[[noreturn]] void _Usage(const char* _Message)
+{
+    std::fprintf(stderr, "gen_prelude: %s\n"
+        "usage: gen_prelude [--numerals=N] [--header=FILE] [--module=FILE]\n", _Message);
+    std::exit(2);
+}
+
+bool _Write_file(const char* _Path, const std::string& _Text)
+{
+    std::ofstream _File(_Path, std::ios::binary);
+    _File << _Text;
+    if (!_File.flush()) {
+        std::fprintf(stderr, "gen_prelude: cannot write %s\n", _Path);
+        return false;
+    }
+
+    return true;
+}
+
+} // unnamed namespace
+
+int main(int _Argc, char** _Argv)
+{
+    unsigned long long _Limit = 16;
+    const char* _Header = "NightlyPrelude.h";
+    const char* _Module = "NightlyPrelude.cppm";
+    for (int _Idx = 1; _Idx < _Argc; ++_Idx) {
+        const char* _Arg = _Argv[_Idx];
+        if (std::strcmp(_Arg, "--help") == 0) {
+            _Usage("generates the prelude of pre-normalized standard terms");
+        }
+
+        const char* _Value = std::strchr(_Arg, '=');
+        if (!_Value) {
+            _Usage("options take their value as --name=value");
+        }
+
+        const std::string _Name(_Arg, static_cast<size_t>(_Value - _Arg));
+        ++_Value;
+        if (_Name == "--numerals") {
+            char* _End = nullptr;
+            _Limit = std::strtoull(_Value, &_End, 10);
+            if (*_Value == '\0' || *_End != '\0' || *_Value == '-' || _Limit > 4096) {
+                _Usage("--numerals takes a count up to 4096");
+            }
+        } else if (_Name == "--header") {
+            _Header = _Value;
+        } else if (_Name == "--module") {
+            _Module = _Value;
+        } else {
+            _Usage("unknown option");
+        }
+    }
+
+    const std::vector<_Term> _Terms = _Standard_terms();
+    std::vector<_Term> _Numerals;
+    for (unsigned long long _Count = 0; _Count <= _Limit; ++_Count) {
+        _Numerals.push_back(_Numeral(_Count));
+    }
+
+    std::ostringstream _Header_text;
+    _Write_header(_Header_text, _Terms, _Numerals);
+    std::ostringstream _Module_text;
+    _Write_module(_Module_text, static_cast<size_t>(_Limit));
+    return _Write_file(_Header, _Header_text.str()) && _Write_file(_Module, _Module_text.str()) ? 0 : 1;
+}
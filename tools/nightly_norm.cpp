@@ -0,0 +1,490 @@
+// nightly_norm.cpp - normalizes files of lambda terms on all cores,
+//
+// Copyright (c) 2020 Yuan Ruihong all rights reserved.
+
+// usage: nightly_norm [options] [input|-]
+//
+//   --strategy=normal|applicative|full|nbe
+//                                        reduction order or normalization by evaluation
+//                                        (default normal)
+//   --fuel=N                             at most N steps per term (default unlimited)
+//   --threads=N                          worker threads (default: all cores)
+//   --format=text|json                   output records (default text)
+//   --output=FILE                        write records to FILE instead of stdout
+//
+// The input holds one term per line in the syntax of `operator<<`; blank lines and lines
+// starting with '#' are skipped. Files are mapped into memory where the platform allows it,
+// anything else is read in large blocks. Lines are cut into chunks that the workers claim
+// in turn, and the writer emits the chunks strictly in input order. A summary with the
+// throughput goes to stderr.
+//
+// A term that runs out of fuel is reported with the reduct reached so far, except under
+// --strategy=nbe, which has no such reduct and reports the input unreduced: "out-of-fuel"
+// and "out-of-fuel, unreduced" in text, "reduced" true or false in json.
+
+#include "../NightlyNbe.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NIGHTLY_NORM_HAS_MMAP 1
+#endif
+
+namespace {
+
+using namespace nightly_lambda::runtime;
+using _Clock = std::chrono::steady_clock;
+
+constexpr size_t _Chunk_lines = 256;   // lines claimed by a worker at once
+constexpr size_t _Chunks_in_flight = 4; // per thread, bounds the memory held by results
+constexpr size_t _Read_block = size_t{1} << 20;
+
+enum class _Output_format { text, json };
+
+struct _Options {
+    reduction_options reduction;
+    bool nbe = false;
+    unsigned threads = 0;
+    _Output_format format = _Output_format::text;
+    const char* input = "-";
+    const char* output = nullptr;
+};
+
+[[noreturn]] void _Usage(const char* _Message)
+{
+    std::fprintf(stderr, "nightly_norm: %s\n"
+        "usage: nightly_norm [--strategy=normal|applicative|full|nbe] [--fuel=N]\n"
+        "                    [--threads=N] [--format=text|json] [--output=FILE] [input|-]\n", _Message);
+    std::exit(2);
+}
+
+unsigned long long _Parse_count(const char* _Text, const char* _Option)
+{
+    char* _End = nullptr;
+    const unsigned long long _Value = std::strtoull(_Text, &_End, 10);
+    if (*_Text == '\0' || *_End != '\0' || *_Text == '-') {
+        std::fprintf(stderr, "nightly_norm: invalid value for %s: %s\n", _Option, _Text);
+        std::exit(2);
+    }
+
+    return _Value;
+}
+
+_Options _Parse_options(int _Argc, char** _Argv)
+{
+    _Options _Result;
+    bool _Has_input = false;
+    for (int _Idx = 1; _Idx < _Argc; ++_Idx) {
+        const char* _Arg = _Argv[_Idx];
+        const char* _Value = std::strchr(_Arg, '=');
+        const std::string_view _Name(_Arg, _Value ? static_cast<size_t>(_Value - _Arg) : std::strlen(_Arg));
+        if (_Name.substr(0, 2) != "--" || _Name == "--") {
+            if (_Has_input) {
+                _Usage("more than one input");
+            }
+
+            _Result.input = _Arg;
+            _Has_input = true;
+            continue;
+        }
+
+        if (_Name == "--help") {
+            _Usage("normalizes one lambda term per line");
+        }
+
+        if (!_Value) {
+            _Usage("options take their value as --name=value");
+        }
+
+        ++_Value;
+        if (_Name == "--strategy") {
+            if (std::strcmp(_Value, "normal") == 0) {
+                _Result.reduction.strategy = reduction_strategy::normal;
+            } else if (std::strcmp(_Value, "applicative") == 0) {
+                _Result.reduction.strategy = reduction_strategy::applicative;
+            } else if (std::strcmp(_Value, "full") == 0) {
+                _Result.reduction.strategy = reduction_strategy::full;
+            } else if (std::strcmp(_Value, "nbe") == 0) {
+                _Result.nbe = true;
+            } else {
+                _Usage("unknown strategy");
+            }
+        } else if (_Name == "--fuel") {
+            _Result.reduction.fuel = _Parse_count(_Value, "--fuel");
+        } else if (_Name == "--threads") {
+            _Result.threads = static_cast<unsigned>(_Parse_count(_Value, "--threads"));
+        } else if (_Name == "--format") {
+            if (std::strcmp(_Value, "text") == 0) {
+                _Result.format = _Output_format::text;
+            } else if (std::strcmp(_Value, "json") == 0) {
+                _Result.format = _Output_format::json;
+            } else {
+                _Usage("unknown format");
+            }
+        } else if (_Name == "--output") {
+            _Result.output = _Value;
+        } else {
+            _Usage("unknown option");
+        }
+    }
+
+    if (_Result.threads == 0) {
+        _Result.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    return _Result;
+}
+
+// CLASS _Input_text
+class _Input_text { // the whole input, mapped or read in large blocks
+public:
+    explicit _Input_text(const char* _Path)
+    {
+        const bool _Is_stdin = std::strcmp(_Path, "-") == 0;
+#ifdef NIGHTLY_NORM_HAS_MMAP
+        if (!_Is_stdin) {
+            const int _Fd = ::open(_Path, O_RDONLY);
+            if (_Fd < 0) {
+                _Fail(_Path);
+            }
+
+            struct stat _Info;
+            if (::fstat(_Fd, &_Info) == 0 && S_ISREG(_Info.st_mode)) {
+                _Mapped_size = static_cast<size_t>(_Info.st_size);
+                if (_Mapped_size != 0) {
+                    void* _Addr = ::mmap(nullptr, _Mapped_size, PROT_READ, MAP_PRIVATE, _Fd, 0);
+                    if (_Addr != MAP_FAILED) {
+                        ::madvise(_Addr, _Mapped_size, MADV_SEQUENTIAL);
+                        _Mapped = _Addr;
+                        _View = std::string_view(static_cast<const char*>(_Addr), _Mapped_size);
+                        ::close(_Fd);
+                        return;
+                    }
+                }
+            }
+
+            ::close(_Fd);
+        }
+#endif // NIGHTLY_NORM_HAS_MMAP
+
+        std::FILE* _File = _Is_stdin ? stdin : std::fopen(_Path, "rb");
+        if (!_File) {
+            _Fail(_Path);
+        }
+
+        for (;;) {
+            const size_t _Old = _Buffer.size();
+            _Buffer.resize(_Old + _Read_block);
+            const size_t _Got = std::fread(&_Buffer[_Old], 1, _Read_block, _File);
+            _Buffer.resize(_Old + _Got);
+            if (_Got < _Read_block) {
+                break;
+            }
+        }
+
+        if (!_Is_stdin) {
+            std::fclose(_File);
+        }
+
+        _View = _Buffer;
+    }
+
+    _Input_text(const _Input_text&) = delete;
+    _Input_text& operator=(const _Input_text&) = delete;
+
+    ~_Input_text()
+    {
+#ifdef NIGHTLY_NORM_HAS_MMAP
+        if (_Mapped) {
+            ::munmap(_Mapped, _Mapped_size);
+        }
+#endif // NIGHTLY_NORM_HAS_MMAP
+    }
+
+    std::string_view view() const noexcept
+    {
+        return _View;
+    }
+
+private:
+    [[noreturn]] static void _Fail(const char* _Path)
+    {
+        std::fprintf(stderr, "nightly_norm: cannot read %s: %s\n", _Path, std::strerror(errno));
+        std::exit(1);
+    }
+
+    std::string _Buffer;
+    std::string_view _View;
+    void* _Mapped = nullptr;
+    size_t _Mapped_size = 0;
+};
+
+struct _Line {
+    std::string_view text;
+    size_t number; // 1-based, for diagnostics
+};
+
+std::vector<_Line> _Split_lines(std::string_view _Text)
+{
+    std::vector<_Line> _Result;
+    size_t _Number = 0;
+    while (!_Text.empty()) {
+        ++_Number;
+        const size_t _Eol = _Text.find('\n');
+        std::string_view _Line = _Text.substr(0, _Eol);
+        _Text = _Eol == std::string_view::npos ? std::string_view() : _Text.substr(_Eol + 1);
+        const size_t _First = _Line.find_first_not_of(" \t\r");
+        if (_First == std::string_view::npos || _Line[_First] == '#') {
+            continue;
+        }
+
+        _Result.push_back({_Line, _Number});
+    }
+
+    return _Result;
+}
+
+void _Append_json_string(std::string& _Out, std::string_view _Text)
+{
+    _Out += '"';
+    for (const char _Ch : _Text) {
+        if (_Ch == '"' || _Ch == '\\') {
+            _Out += '\\';
+            _Out += _Ch;
+        } else if (static_cast<unsigned char>(_Ch) < 0x20) {
+            char _Escape[8];
+            std::snprintf(_Escape, sizeof(_Escape), "\\u%04x", static_cast<unsigned>(_Ch));
+            _Out += _Escape;
+        } else {
+            _Out += _Ch;
+        }
+    }
+
+    _Out += '"';
+}
+
+// CLASS _Worker_state
+class _Worker_state { // per-thread scratch, reused for every term
+public:
+    explicit _Worker_state(const _Options& _Opts_) noexcept : _Opts(_Opts_) {}
+
+    void process(const _Line& _Input, std::string& _Out)
+    {
+        _Arena.reset(); // with the names, which would otherwise pile up from term to term
+        reduction_stats _Stats;
+        const auto _Start = _Clock::now();
+        try {
+            const term_ref _Term = parse_term(_Arena, _Input.text);
+            _Result_text.clear();
+            const term_ref _Normal = _Opts.nbe ? _Engine.normalize(_Arena, _Term, _Opts.reduction, _Stats)
+                : normalize(_Arena, _Term, _Opts.reduction, _Stats);
+            append_term(_Result_text, _Arena, _Normal);
+        } catch (const parse_error& _Err) {
+            _Write_error(_Out, _Input, _Err.what(), _Err.position());
+            return;
+        } catch (const std::exception& _Err) {
+            _Write_error(_Out, _Input, _Err.what(), std::string_view::npos);
+            return;
+        }
+
+        const auto _Nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            _Clock::now() - _Start).count();
+        _Write_result(_Out, _Input, _Stats, static_cast<long long>(_Nanos));
+    }
+
+private:
+    bool _Unreduced(const reduction_stats& _Stats) const noexcept
+    { // `nbe_engine` gives back its input when the fuel runs out, `normalize` the reduct so far
+        return _Stats.exhausted && _Opts.nbe;
+    }
+
+    void _Write_result(std::string& _Out, const _Line& _Input
+        , const reduction_stats& _Stats, long long _Nanos)
+    {
+        char _Numbers[192];
+        if (_Opts.format == _Output_format::json) {
+            _Out += "{\"line\":";
+            _Out += std::to_string(_Input.number);
+            _Out += ",\"result\":";
+            _Append_json_string(_Out, _Result_text);
+            std::snprintf(_Numbers, sizeof(_Numbers)
+                , ",\"steps\":%llu,\"peak_size\":%llu,\"time_ns\":%lld,\"normal_form\":%s,\"reduced\":%s}\n"
+                , static_cast<unsigned long long>(_Stats.steps)
+                , static_cast<unsigned long long>(_Stats.peak_size)
+                , _Nanos, _Stats.exhausted ? "false" : "true", _Unreduced(_Stats) ? "false" : "true");
+        } else {
+            _Out += _Result_text;
+            std::snprintf(_Numbers, sizeof(_Numbers)
+                , "\tsteps=%llu peak=%llu time=%.3fus%s\n"
+                , static_cast<unsigned long long>(_Stats.steps)
+                , static_cast<unsigned long long>(_Stats.peak_size)
+                , static_cast<double>(_Nanos) / 1000.0
+                , _Unreduced(_Stats) ? " out-of-fuel, unreduced" : _Stats.exhausted ? " out-of-fuel" : "");
+        }
+
+        _Out += _Numbers;
+    }
+
+    void _Write_error(std::string& _Out, const _Line& _Input, const char* _Message, size_t _Column)
+    {
+        if (_Opts.format == _Output_format::json) {
+            _Out += "{\"line\":";
+            _Out += std::to_string(_Input.number);
+            _Out += ",\"error\":";
+            _Append_json_string(_Out, _Message);
+            if (_Column != std::string_view::npos) {
+                _Out += ",\"column\":";
+                _Out += std::to_string(_Column + 1);
+            }
+
+            _Out += "}\n";
+        } else {
+            _Out += "error: line ";
+            _Out += std::to_string(_Input.number);
+            if (_Column != std::string_view::npos) {
+                _Out += ':';
+                _Out += std::to_string(_Column + 1);
+            }
+
+            _Out += ": ";
+            _Out += _Message;
+            _Out += '\n';
+        }
+    }
+
+    const _Options& _Opts;
+    term_arena _Arena;
+    nbe_engine _Engine;
+    std::string _Result_text;
+};
+
+// CLASS _Ordered_chunks
+class _Ordered_chunks { // hands out chunks to workers and returns them to the writer in order
+public:
+    _Ordered_chunks(size_t _Count_, size_t _Window_) : _Count(_Count_), _Window(_Window_) {}
+
+    bool claim(size_t& _Chunk)
+    { // blocks while the writer is too far behind
+        std::unique_lock<std::mutex> _Lock(_Mutex);
+        _Can_claim.wait(_Lock, [this] { return _Next_claim >= _Count || _Next_claim < _Next_write + _Window; });
+        if (_Next_claim >= _Count) {
+            return false;
+        }
+
+        _Chunk = _Next_claim++;
+        return true;
+    }
+
+    void complete(size_t _Chunk, std::string&& _Text)
+    {
+        {
+            std::lock_guard<std::mutex> _Lock(_Mutex);
+            _Done.emplace(_Chunk, std::move(_Text));
+        }
+
+        _Can_write.notify_one();
+    }
+
+    bool next(std::string& _Text)
+    { // blocks until the chunk after the last written one is done
+        std::unique_lock<std::mutex> _Lock(_Mutex);
+        if (_Next_write >= _Count) {
+            return false;
+        }
+
+        _Can_write.wait(_Lock, [this] { return _Done.count(_Next_write) != 0; });
+        const auto _Found = _Done.find(_Next_write);
+        _Text = std::move(_Found->second);
+        _Done.erase(_Found);
+        ++_Next_write;
+        _Lock.unlock();
+        _Can_claim.notify_all();
+        return true;
+    }
+
+private:
+    std::mutex _Mutex;
+    std::condition_variable _Can_claim;
+    std::condition_variable _Can_write;
+    std::unordered_map<size_t, std::string> _Done;
+    size_t _Count;
+    size_t _Window;
+    size_t _Next_claim = 0;
+    size_t _Next_write = 0;
+};
+
+} // unnamed namespace
+
+int main(int _Argc, char** _Argv)
+{
+    const _Options _Opts = _Parse_options(_Argc, _Argv);
+    const auto _Start = _Clock::now();
+
+    const _Input_text _Input(_Opts.input);
+    const std::vector<_Line> _Lines = _Split_lines(_Input.view());
+
+    std::FILE* _Out = _Opts.output ? std::fopen(_Opts.output, "wb") : stdout;
+    if (!_Out) {
+        std::fprintf(stderr, "nightly_norm: cannot write %s: %s\n", _Opts.output, std::strerror(errno));
+        return 1;
+    }
+
+    const size_t _Chunk_count = (_Lines.size() + _Chunk_lines - 1) / _Chunk_lines;
+    _Ordered_chunks _Chunks(_Chunk_count, _Chunks_in_flight * _Opts.threads);
+    std::vector<std::thread> _Workers;
+    _Workers.reserve(_Opts.threads);
+    for (unsigned _Idx = 0; _Idx < _Opts.threads; ++_Idx) {
+        _Workers.emplace_back([&] {
+            _Worker_state _State(_Opts);
+            size_t _Chunk;
+            while (_Chunks.claim(_Chunk)) {
+                std::string _Text;
+                const size_t _End = std::min(_Lines.size(), (_Chunk + 1) * _Chunk_lines);
+                for (size_t _Line = _Chunk * _Chunk_lines; _Line < _End; ++_Line) {
+                    _State.process(_Lines[_Line], _Text);
+                }
+
+                _Chunks.complete(_Chunk, std::move(_Text));
+            }
+        });
+    }
+
+    std::string _Text;
+    bool _Write_failed = false;
+    while (_Chunks.next(_Text)) {
+        if (!_Write_failed && std::fwrite(_Text.data(), 1, _Text.size(), _Out) != _Text.size()) {
+            _Write_failed = true; // keep draining so that the workers can finish
+        }
+    }
+
+    for (auto& _Worker : _Workers) {
+        _Worker.join();
+    }
+
+    if (std::fflush(_Out) != 0 || (_Opts.output && std::fclose(_Out) != 0)) {
+        _Write_failed = true;
+    }
+
+    const double _Seconds = std::chrono::duration<double>(_Clock::now() - _Start).count();
+    std::fprintf(stderr, "nightly_norm: %zu terms in %.3fs on %u threads, %.0f terms/s\n"
+        , _Lines.size(), _Seconds, _Opts.threads
+        , _Seconds > 0 ? static_cast<double>(_Lines.size()) / _Seconds : 0.0);
+    if (_Write_failed) {
+        std::fprintf(stderr, "nightly_norm: write error\n");
+        return 1;
+    }
+
+    return 0;
+}
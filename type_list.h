@@ -23,7 +23,9 @@
 // dependencies only on C++14 and standard library <tuple>. All implementations are arranged
 // inside namespace `std_ext` and are written in a style akin to the standard library.
 
+#include <cstddef>
 #include <tuple>
+#include <type_traits>
 
 namespace std_ext {
 